@@ -137,6 +137,7 @@ bool CCDirector::init()
 	
 	m_fDeltaTime = 0.0f;
 	m_fRealDeltaTime = 0.0f;
+	m_fFixedDeltaTime = 0.0f;
 	m_fUpdateInterval = 0.0f;
 	m_fDrawInterval = 0.0f;
 	m_uLastNumberOfDraws = 0;
@@ -330,6 +331,10 @@ void CCDirector::calculateDeltaTime()
 		m_fRealDeltaTime = MAX(0, m_fRealDeltaTime);
 		m_fDeltaTime = MIN(1.0f/30.0f, m_fRealDeltaTime);
 	}
+	if (m_fFixedDeltaTime > 0.0f)
+	{
+		m_fDeltaTime = m_fFixedDeltaTime;
+	}
 	s_obLastUpdate = now;
 }
 
@@ -338,6 +343,16 @@ float CCDirector::getDeltaTime()
 	return m_fDeltaTime;
 }
 
+void CCDirector::setFixedDeltaTime(float var)
+{
+	m_fFixedDeltaTime = var;
+}
+
+float CCDirector::getFixedDeltaTime()
+{
+	return m_fFixedDeltaTime;
+}
+
 void CCDirector::setOpenGLView(CCEGLView *pobOpenGLView)
 {
 	CCAssert(pobOpenGLView, "opengl view should not be null");
@@ -1036,6 +1051,22 @@ void CCDirector::unscheduleUpdateLua()
 	}
 }
 
+void CCDirector::step(float deltaTime)
+{
+	// objects autoreleased before the step stay in the outer pool
+	CCPoolManager::sharedPoolManager()->push();
+	m_fDeltaTime = deltaTime;
+	if (m_nHandler)
+	{
+		if (CCScriptEngine::sharedEngine()->executeFunction(m_nHandler, 0) != 0)
+		{
+			CCDirector::unscheduleUpdateLua();
+		}
+	}
+	m_pScheduler->update(m_fDeltaTime);
+	CCPoolManager::sharedPoolManager()->pop();
+}
+
 /***************************************************
 * implementation of DisplayLinkDirector
 **************************************************/
@@ -1083,6 +1114,9 @@ void CCDisplayLinkDirector::mainLoop()
 				m_fDrawInterval = CCDirector::getInterval(s_obLastUpdate) - m_fUpdateInterval;
 				// release the objects
 				CCPoolManager::sharedPoolManager()->pop();
+				// spend the frame slack on script garbage
+				float slack = (float)m_dAnimationInterval - CCDirector::getInterval(s_obLastUpdate);
+				CCScriptEngine::sharedEngine()->collectGarbage(slack);
 			}
 		}
 	}
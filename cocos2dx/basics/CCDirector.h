@@ -299,6 +299,12 @@ public:
 
 	void scheduleUpdateLua(int handler);
 	void unscheduleUpdateLua();
+
+	/** Advances one frame by the given delta time without drawing,
+	 runs the Lua main loop handler and the scheduler in a new autorelease pool.
+	 Used to replay or simulate frames offscreen. Must not be called from scheduled code.
+	 */
+	void step(float deltaTime);
 public:
 	/** CCScheduler associated with this director
 	 @since v2.0
@@ -323,6 +329,9 @@ public:
 	/* delta time since last tick to main loop */
 	CC_PROPERTY_READONLY(float, m_fDeltaTime, DeltaTime);
 
+	/* when greater than 0, every tick advances by this delta time regardless of the frame time */
+	CC_PROPERTY(float, m_fFixedDeltaTime, FixedDeltaTime);
+
 	CC_PROPERTY_READONLY(float, m_fUpdateInterval, UpdateInterval);
 	CC_PROPERTY_READONLY(float, m_fDrawInterval, DrawInterval);
 
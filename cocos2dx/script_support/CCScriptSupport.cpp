@@ -152,5 +152,7 @@ bool CCScriptEngine::scriptHandlerEqual(int nHandlerA, int nHandlerB){ return fa
 int CCScriptEngine::executeActionCreate(int nHandler){ return 0; }
 int CCScriptEngine::executeActionUpdate(int nHandler, void* param, int paramType, float deltaTime){ return 0; }
 void CCScriptEngine::removePeer(CCObject* object){}
+void CCScriptEngine::removeUserType(void* value){}
+void CCScriptEngine::collectGarbage(float budget){}
 
 NS_CC_END
@@ -155,6 +155,12 @@ public:
 
 	virtual void removePeer(CCObject* object);
 
+	/** forget the box of a plain C++ object pushed by address, called before it is deleted */
+	virtual void removeUserType(void* value);
+
+	/** run garbage collection in the idle time left in a frame, budget in seconds */
+	virtual void collectGarbage(float budget);
+
 	static void setEngine(CCScriptEngine* engine);
 	static CCScriptEngine* sharedEngine();
 private:
@@ -265,8 +265,14 @@ const char* StrPair::GetStr()
 }
 
 // --------- XMLUtil ----------- //
-static const char* g_cdataHeader;
-static void(*g_headerHandler)(const char*, const char*);
+// Per thread, so documents can be parsed on several threads at once.
+#if defined(_MSC_VER)
+#define TINYXML2_THREAD_LOCAL __declspec(thread)
+#else
+#define TINYXML2_THREAD_LOCAL __thread
+#endif
+static TINYXML2_THREAD_LOCAL const char* g_cdataHeader;
+static TINYXML2_THREAD_LOCAL void(*g_headerHandler)(const char*, const char*);
 void XMLUtil::PlaceCDataHeader(const char* mocdataLHeader)
 {
 	g_cdataHeader = mocdataLHeader;
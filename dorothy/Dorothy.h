@@ -16,6 +16,7 @@
 #include "misc/oLine.h"
 //event
 #include "event/oEvent.h"
+#include "event/oEventQueue.h"
 #include "event/oListener.h"
 
 //model
@@ -55,6 +56,8 @@
 #include "platform/oBulletDef.h"
 #include "platform/oCamera.h"
 #include "platform/oData.h"
+#include "platform/oLockstep.h"
+#include "platform/oSimulation.h"
 #include "platform/oPlatformDefine.h"
 #include "platform/oPlatformWorld.h"
 #include "platform/oProperty.h"
@@ -10,73 +10,166 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include "event/oEvent.h"
 #include "event/oEventType.h"
 #include "event/oListener.h"
+#include "event/oEventQueue.h"
+#include "misc/oIdTable.h"
 
 NS_DOROTHY_BEGIN
 
-oEvent oEvent::_event;
+static oIdTable& oGetEventNames()
+{
+	static oIdTable names;
+	return names;
+}
+
+oEventId::oEventId( const string& name ):
+_id(oGetEventNames().getId(name))
+{ }
 
-oEvent::oEvent()
-{}
+oEventId::oEventId( const char* name ):
+_id(oGetEventNames().getId(name))
+{ }
 
-oEvent::oEvent( const string& name ):
-_name(name)
+const string& oEventId::getName() const
+{
+	return oGetEventNames().getName(_id);
+}
+
+vector<oOwn<oEventType>> oEvent::_eventTypes;
+vector<oOwn<oEventBufferBase>> oEvent::_buffers;
+bool oEvent::_flushScheduled = false;
+bool oEvent::_flushing = false;
+oEvent* oEvent::_batchEvent = nullptr;
+Delegate<void ()> oEvent::batchEnd;
+
+class oEventFlusher: public CCObject
+{
+public:
+	virtual ~oEventFlusher()
+	{
+		//Unscheduled by the scheduler, as when purging the director
+		oEvent::_flushScheduled = false;
+	}
+	virtual void update(float dt)
+	{
+		oEvent::flush();
+	}
+	static oEventFlusher* create()
+	{
+		oEventFlusher* flusher = new oEventFlusher();
+		flusher->autorelease();
+		return flusher;
+	}
+};
+
+oEvent::oEvent( oEventId id ):
+_id(id)
 { }
 
-unordered_map<string, oOwn<oEventType>> oEvent::_eventMap;
+oEvent::oEvent( const string& name ):
+_id(name)
+{ }
 
 void oEvent::clear()
 {
-	_eventMap.clear();
+	_eventTypes.clear();
 }
 
 void oEvent::unreg( oListener* listener )
 {
-	auto it = _eventMap.find(listener->getName());
-	if (it != _eventMap.end())
+	int id = listener->getId().getValue();
+	if (id < (int)_eventTypes.size() && _eventTypes[id])
 	{
-		oEventType* type = it->second;
-		type->remove(listener);
-		if (type->isEmpty())
-		{
-			_eventMap.erase(it);
-		}
+		_eventTypes[id]->remove(listener);
 	}
 }
 
 void oEvent::reg( oListener* listener )
 {
-	auto it = _eventMap.find(listener->getName());
-	if (it != _eventMap.end())
+	int id = listener->getId().getValue();
+	if ((int)_eventTypes.size() <= id)
 	{
-		it->second->add(listener);
+		_eventTypes.resize(id + 1);
 	}
-	else
+	if (!_eventTypes[id])
 	{
-		oEventType* type = new oEventType(listener->getName());
-		_eventMap[listener->getName()] = oOwnMake(type);
-		type->add(listener);
+		_eventTypes[id] = oOwnMake(new oEventType(listener->getId()));
 	}
+	_eventTypes[id]->add(listener);
+	//Keep flushing while anyone listens, so events posted from worker threads are drained
+	oEvent::scheduleFlush();
 }
 
 void oEvent::send( oEvent* e )
 {
-	auto it = _eventMap.find(e->getName());
-	if (it != _eventMap.end())
+	int id = e->getId().getValue();
+	if (id < (int)_eventTypes.size() && _eventTypes[id])
 	{
-		it->second->handle(e);
+		_eventTypes[id]->handle(e);
 	}
 }
 
+oListener* oEvent::addListener( oEventId id, const oEventHandler& handler )
+{
+	return oListener::create(id, handler);
+}
+
 oListener* oEvent::addListener( const string& name, const oEventHandler& handler )
 {
-	oListener* listener = oListener::create(name, handler);
-	return listener;
+	return oListener::create(oEventId(name), handler);
+}
+
+void oEvent::send( oEventId id )
+{
+	oEvent event(id);
+	oEvent::send(&event);
+}
+
+void oEvent::send( const string& name )
+{
+	oEvent::send(oEventId(name));
+}
+
+void oEvent::send( const char* name )
+{
+	oEvent::send(oEventId(name));
+}
+
+void oEvent::post( oEventId id, bool coalesce )
+{
+	oEventBuffer<oEvent>::shared()->post(oEvent(id), coalesce);
+}
+
+void oEvent::flush()
+{
+	//A handler flushing again would drain worker events out of order
+	if (_flushing) return;
+	_flushing = true;
+	oEventQueue::drain();
+	for (size_t i = 0; i < _buffers.size(); i++)
+	{
+		_buffers[i]->flush();
+	}
+	_flushing = false;
+}
+
+bool oEvent::isBatched( oEvent* event )
+{
+	return event == _batchEvent;
+}
+
+void oEvent::addBuffer( oEventBufferBase* buffer )
+{
+	_buffers.push_back(oOwnMake(buffer));
 }
 
-void oEvent::send(const string& name)
+void oEvent::scheduleFlush()
 {
-	_event._name = name;
-	oEvent::send(&_event);
+	if (!_flushScheduled)
+	{
+		_flushScheduled = true;
+		//Flush after all other scheduled updates, the scheduler keeps the flusher alive
+		CCDirector::sharedDirector()->getScheduler()->scheduleUpdateForTarget(oEventFlusher::create(), INT_MAX, false);
+	}
 }
 
 NS_DOROTHY_END
\ No newline at end of file
@@ -14,23 +14,42 @@ NS_DOROTHY_BEGIN
 class oListener;
 class oEventType;
 class oEvent;
+class oEventBufferBase;
 typedef Delegate<void (oEvent* event)> oEventHandler;
 
+/** @brief Handle of an event name interned into a small integer.
+ Create handles once and keep them, sending and registering
+ with a handle needs no string copy or hashing.
+*/
+class oEventId
+{
+public:
+	explicit oEventId(const string& name);
+	/** Lookup cached by the string address, for names passed from scripts. */
+	explicit oEventId(const char* name);
+	inline int getValue() const { return _id; }
+	const string& getName() const;
+	inline bool operator==(const oEventId& other) const { return _id == other._id; }
+	inline bool operator!=(const oEventId& other) const { return _id != other._id; }
+private:
+	oEventId(int id):_id(id) {}
+	int _id;
+	friend class oEventQueue;
+};
+
 /** @brief The event system is associate with event,
  event type and event listener.Use the system as following.
  @example // Self defined event.
  class MyEvent: public oEvent
  {
 	public:
+		MyEvent(oEventId id, int arg):oEvent(id),arg(arg){}
 		int arg;
-		void send(const string& name, int arg)
+		static void send(oEventId id, int arg)
 		{
-			_event._name = name;
-			_event.arg = arg;
-			oEvent::send(&_event);
+			MyEvent event(id, arg);
+			oEvent::send(&event);
 		}
-	private:
-		static MyEvent _event;
  };
  
  // Event callback function.
@@ -41,7 +60,7 @@ typedef Delegate<void (oEvent* event)> oEventHandler;
  }
 
  // Name your new event.
- const string MYEVENT_A = "EventA";
+ const oEventId MYEVENT_A("EventA");
 
  // Register for event.
  _listener = MyEvent::addListener(MYEVENT_A, onMyEvent);
@@ -49,28 +68,144 @@ typedef Delegate<void (oEvent* event)> oEventHandler;
 
  // Send event, then the callback function should be invoked.
  MyEvent::send(MYEVENT_A, 123);
+
+ // Or queue it, the callback function is invoked at the next flush.
+ oEvent::post(MyEvent(MYEVENT_A, 123));
 */
 class oEvent
 {
 public:
-	oEvent();
+	oEvent(oEventId id);
 	oEvent(const string& name);
-	inline const string& getName() const { return _name; }
+	inline oEventId getId() const { return _id; }
+	inline const string& getName() const { return _id.getName(); }
 public:
+	static oListener* addListener(oEventId id, const oEventHandler& handler);
 	static oListener* addListener(const string& name, const oEventHandler& handler);
+	static void send(oEventId id);
 	static void send(const string& name);
+	static void send(const char* name);
+	/** Send an event with its payload, the event is usually on the stack. */
+	static void send(oEvent* event);
+	/**
+	 Queue an event to be sent at the next flush. Events posted while
+	 flushing are sent at the flush after, so handlers never recurse.
+	 A coalesced event replaces the queued event of the same id
+	 and payload type instead of being queued again.
+	 */
+	static void post(oEventId id, bool coalesce = false);
+	template<class Event>
+	static void post(const Event& event, bool coalesce = false);
+	/** Send events posted from worker threads and all queued events now,
+	 also done once per frame after scheduled updates.
+	 Calling it from a handler during a flush does nothing. */
+	static void flush();
 	static void clear();
+	/** True when the event is a posted one being sent by a flush, it stays
+	 alive until batchEnd is invoked so handlers may gather it. */
+	static bool isBatched(oEvent* event);
+	/** Invoked after each queue of posted events is sent by a flush. */
+	static Delegate<void ()> batchEnd;
 private:
 	static void reg(oListener* listener);
 	static void unreg(oListener* listener);
-	static unordered_map<string, oOwn<oEventType>> _eventMap;
-	static oEvent _event;
+	static void addBuffer(oEventBufferBase* buffer);
+	static void scheduleFlush();
+	static vector<oOwn<oEventType>> _eventTypes;//Indexed by event id
+	static vector<oOwn<oEventBufferBase>> _buffers;
+	static bool _flushScheduled;
+	static bool _flushing;
+	static oEvent* _batchEvent;
 protected:
-	static void send(oEvent* event);
-	string _name;
+	oEventId _id;
 	friend class oListener;
+	friend class oEventFlusher;
+	template<class Event>
+	friend class oEventBuffer;
+};
+
+/** @brief Base of the queues of posted events, one queue for each payload type. */
+class oEventBufferBase
+{
+public:
+	virtual ~oEventBufferBase() {}
+	virtual void flush() = 0;
+};
+
+/** @brief Double buffered queue of posted events with the same payload type. */
+template<class Event>
+class oEventBuffer: public oEventBufferBase
+{
+public:
+	void post(const Event& event, bool coalesce)
+	{
+		int id = event.getId().getValue();
+		if (coalesce)
+		{
+			if ((int)_positions.size() <= id)
+			{
+				_positions.resize(id + 1, -1);
+			}
+			int& position = _positions[id];
+			if (position >= 0)
+			{
+				_back[position] = event;
+				return;
+			}
+			position = (int)_back.size();
+		}
+		_back.push_back(event);
+		oEvent::scheduleFlush();
+	}
+	oEventBuffer():_flushing(false)
+	{ }
+	virtual void flush()
+	{
+		//A handler flushing again would swap the batch being sent
+		if (_flushing || _back.empty()) return;
+		_flushing = true;
+		_front.swap(_back);
+		for (const Event& event : _front)
+		{
+			int id = event.getId().getValue();
+			if (id < (int)_positions.size())
+			{
+				_positions[id] = -1;
+			}
+		}
+		for (size_t i = 0; i < _front.size(); i++)
+		{
+			oEvent::_batchEvent = &_front[i];
+			oEvent::send(&_front[i]);
+		}
+		oEvent::_batchEvent = nullptr;
+		oEvent::batchEnd();
+		_front.clear();
+		_flushing = false;
+	}
+	static oEventBuffer* shared()
+	{
+		static oEventBuffer* buffer = nullptr;
+		if (buffer == nullptr)
+		{
+			buffer = new oEventBuffer();
+			oEvent::addBuffer(buffer);
+		}
+		return buffer;
+	}
+private:
+	vector<Event> _front;
+	vector<Event> _back;
+	vector<int> _positions;//Position of coalesced events in back buffer by event id
+	bool _flushing;
 };
 
+template<class Event>
+void oEvent::post(const Event& event, bool coalesce)
+{
+	oEventBuffer<Event>::shared()->post(event, coalesce);
+}
+
 NS_DOROTHY_END
 
 #endif //__DOROTHY_EVENT_OEVENT_H__
\ No newline at end of file
@@ -0,0 +1,224 @@
+/* Copyright (c) 2013 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include "const/oDefine.h"
+#include "event/oEventQueue.h"
+#include <atomic>
+#include <sched.h>
+
+NS_DOROTHY_BEGIN
+
+struct oQueuedEvent
+{
+	int id;
+	oEvent* event;//nullptr for events without payload
+	void (*release)(oEvent* event);
+};
+
+struct oQueueCell
+{
+	std::atomic<unsigned int> sequence;
+	oQueuedEvent entry;
+};
+
+/* Bounded ring of cells, each cell holds a sequence number telling
+ whether it is free for the producer at that position or filled for the consumer.
+ Producers claim positions with compare and swap on the tail,
+ the single consumer on the main thread owns the head. */
+static oQueueCell* s_cells = nullptr;
+static unsigned int s_mask = 0;
+static std::atomic<unsigned int> s_tail(0);
+static unsigned int s_head = 0;
+static int s_overflowPolicy = oEventQueue::DropNewest;
+static int s_maxDrain = 256;
+static std::atomic<unsigned int> s_posted(0);
+static std::atomic<unsigned int> s_dropped(0);
+static unsigned int s_delivered = 0;
+
+static void oEventQueueAlloc(unsigned int capacity)
+{
+	s_cells = new oQueueCell[capacity];
+	for (unsigned int i = 0; i < capacity; i++)
+	{
+		s_cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+	s_mask = capacity - 1;
+	s_head = 0;
+	s_tail.store(0, std::memory_order_release);
+}
+
+static bool oEventQueuePop(oQueuedEvent& entry)
+{
+	oQueueCell& cell = s_cells[s_head & s_mask];
+	unsigned int sequence = cell.sequence.load(std::memory_order_acquire);
+	if ((int)(sequence - (s_head + 1)) < 0)
+	{
+		return false;
+	}
+	entry = cell.entry;
+	cell.sequence.store(s_head + s_mask + 1, std::memory_order_release);
+	s_head++;
+	return true;
+}
+
+/* Allocated before main runs, so workers never race on creating it. */
+static struct oEventQueueInit
+{
+	oEventQueueInit()
+	{
+		oEventQueueAlloc(1024);
+	}
+} s_init;
+
+bool oEventQueue::push( oEventId id, oEvent* event, oReleaseFunc releaseFunc )
+{
+	unsigned int pos = s_tail.load(std::memory_order_relaxed);
+	oQueueCell* cell;
+	for (;;)
+	{
+		cell = &s_cells[pos & s_mask];
+		unsigned int sequence = cell->sequence.load(std::memory_order_acquire);
+		int diff = (int)(sequence - pos);
+		if (diff == 0)
+		{
+			if (s_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if (diff < 0)
+		{
+			if (s_overflowPolicy == oEventQueue::DropNewest)
+			{
+				s_dropped.fetch_add(1, std::memory_order_relaxed);
+				if (event)
+				{
+					releaseFunc(event);
+				}
+				return false;
+			}
+			sched_yield();
+			pos = s_tail.load(std::memory_order_relaxed);
+		}
+		else
+		{
+			pos = s_tail.load(std::memory_order_relaxed);
+		}
+	}
+	cell->entry.id = id.getValue();
+	cell->entry.event = event;
+	cell->entry.release = releaseFunc;
+	cell->sequence.store(pos + 1, std::memory_order_release);
+	s_posted.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+bool oEventQueue::post( oEventId id )
+{
+	return oEventQueue::push(id, nullptr, nullptr);
+}
+
+void oEventQueue::send( const oQueuedEvent& entry )
+{
+	s_delivered++;
+	if (entry.event)
+	{
+		oEvent::send(entry.event);
+		entry.release(entry.event);
+	}
+	else
+	{
+		oEvent::send(oEventId(entry.id));
+	}
+}
+
+int oEventQueue::drain()
+{
+	int count = 0;
+	oQueuedEvent entry;
+	while ((s_maxDrain == 0 || count < s_maxDrain) && oEventQueuePop(entry))
+	{
+		oEventQueue::send(entry);
+		count++;
+	}
+	return count;
+}
+
+void oEventQueue::setCapacity( int capacity )
+{
+	unsigned int size = 1;
+	while ((int)size < capacity)
+	{
+		size <<= 1;
+	}
+	if (size == s_mask + 1)
+	{
+		return;
+	}
+	oQueuedEvent entry;
+	while (oEventQueuePop(entry))
+	{
+		oEventQueue::send(entry);
+	}
+	delete [] s_cells;
+	oEventQueueAlloc(size);
+}
+
+int oEventQueue::getCapacity()
+{
+	return (int)(s_mask + 1);
+}
+
+void oEventQueue::setOverflowPolicy( int policy )
+{
+	s_overflowPolicy = policy;
+}
+
+int oEventQueue::getOverflowPolicy()
+{
+	return s_overflowPolicy;
+}
+
+void oEventQueue::setMaxDrain( int maxDrain )
+{
+	s_maxDrain = MAX(maxDrain, 0);
+}
+
+int oEventQueue::getMaxDrain()
+{
+	return s_maxDrain;
+}
+
+unsigned int oEventQueue::getPosted()
+{
+	return s_posted.load(std::memory_order_relaxed);
+}
+
+unsigned int oEventQueue::getDropped()
+{
+	return s_dropped.load(std::memory_order_relaxed);
+}
+
+unsigned int oEventQueue::getDelivered()
+{
+	return s_delivered;
+}
+
+int oEventQueue::getPending()
+{
+	return (int)(s_tail.load(std::memory_order_relaxed) - s_head);
+}
+
+void oEventQueue::resetStats()
+{
+	s_posted.store(0, std::memory_order_relaxed);
+	s_dropped.store(0, std::memory_order_relaxed);
+	s_delivered = 0;
+}
+
+NS_DOROTHY_END
\ No newline at end of file
@@ -0,0 +1,72 @@
+/* Copyright (c) 2013 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#ifndef __DOROTHY_EVENT_OEVENTQUEUE_H__
+#define __DOROTHY_EVENT_OEVENTQUEUE_H__
+
+#include "event/oEvent.h"
+
+NS_DOROTHY_BEGIN
+
+struct oQueuedEvent;
+
+/** @brief Lock free queue for worker threads to send events.
+ Any number of threads post into a bounded ring buffer,
+ the main thread drains it during oEvent::flush and sends the events
+ to the oListener handlers. Event ids must be created on the main thread
+ before they are posted, since interning a name is not thread safe.
+*/
+class oEventQueue
+{
+public:
+	enum
+	{
+		DropNewest,//Discard the posted event when the queue is full
+		Wait//Spin until the main thread makes room, never use it from the main thread
+	};
+	/** Post an event without payload from any thread, return false if dropped. */
+	static bool post(oEventId id);
+	/** Post a copy of the event from any thread, return false if dropped. */
+	template<class Event>
+	static bool post(const Event& event);
+	/** Send at most maxDrain posted events on the main thread, return the number sent. */
+	static int drain();
+	/** Change capacity on the main thread while no worker is posting,
+	 pending events are sent first, the capacity is rounded up to a power of two. */
+	static void setCapacity(int capacity);
+	static int getCapacity();
+	static void setOverflowPolicy(int policy);
+	static int getOverflowPolicy();
+	/** Limit events sent per drain, 0 for no limit. */
+	static void setMaxDrain(int maxDrain);
+	static int getMaxDrain();
+	static unsigned int getPosted();
+	static unsigned int getDropped();
+	static unsigned int getDelivered();
+	static int getPending();
+	static void resetStats();
+private:
+	typedef void (*oReleaseFunc)(oEvent* event);
+	template<class Event>
+	static void release(oEvent* event)
+	{
+		delete static_cast<Event*>(event);
+	}
+	static bool push(oEventId id, oEvent* event, oReleaseFunc releaseFunc);
+	static void send(const oQueuedEvent& entry);
+};
+
+template<class Event>
+bool oEventQueue::post(const Event& event)
+{
+	return oEventQueue::push(event.getId(), new Event(event), &oEventQueue::release<Event>);
+}
+
+NS_DOROTHY_END
+
+#endif // __DOROTHY_EVENT_OEVENTQUEUE_H__
\ No newline at end of file
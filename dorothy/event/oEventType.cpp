@@ -13,13 +13,13 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 NS_DOROTHY_BEGIN
 
-oEventType::oEventType( const string& name ):
-_name(name)
+oEventType::oEventType( oEventId id ):
+_id(id)
 { }
 
 const string& oEventType::getName() const
 {
-	return _name;
+	return _id.getName();
 }
 
 void oEventType::add( oListener* listener )
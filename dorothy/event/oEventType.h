@@ -8,6 +8,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #ifndef __DOROTHY_OEVENT_TYPE_H__
 #define __DOROTHY_OEVENT_TYPE_H__
+#include "event/oEvent.h"
 
 NS_DOROTHY_BEGIN
 
@@ -18,14 +19,14 @@ class oListener;
 class oEventType
 {
 public:
-	oEventType(const string& name);
+	oEventType(oEventId id);
 	const string& getName() const;
 	void add(oListener* listener);
 	void remove(oListener* listener);
 	void handle(oEvent* e);
 	bool isEmpty() const;
 protected:
-	string _name;
+	oEventId _id;
 private:
 	vector<oListener*> _listeners;
 };
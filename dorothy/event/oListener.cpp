@@ -57,22 +57,32 @@ void oListener::handle( oEvent* e )
 
 oListener* oListener::create( const string& name, const oEventHandler& handler )
 {
-	oListener* listener = new oListener(name, handler);
+	return oListener::create(oEventId(name), handler);
+}
+
+oListener* oListener::create( oEventId id, const oEventHandler& handler )
+{
+	oListener* listener = new oListener(id, handler);
 	CC_INIT(listener);
 	listener->autorelease();
 	listener->setEnabled(true);
 	return listener;
 }
 
-oListener::oListener( const string& name, const oEventHandler& handler ):
-_name(name),
+oListener::oListener( oEventId id, const oEventHandler& handler ):
+_id(id),
 _handler(handler),
 _order(INVALID_ORDER)
 { }
 
+oEventId oListener::getId() const
+{
+	return _id;
+}
+
 const string& oListener::getName() const
 {
-	return _name;
+	return _id.getName();
 }
 
 oListener::~oListener()
@@ -8,6 +8,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #ifndef __DOROTHY_OLISTENER_H__
 #define __DOROTHY_OLISTENER_H__
+#include "event/oEvent.h"
 
 NS_DOROTHY_BEGIN
 
@@ -21,6 +22,7 @@ class oListener: public CCObject
 {
 public:
 	~oListener();
+	oEventId getId() const;
 	const string& getName() const;
 	/** True to receive event and handle it, false to not receive event. */
 	void setEnabled(bool enable);
@@ -34,12 +36,12 @@ public:
 	/** Invoked when event is received. */
 	void handle(oEvent* e);
 	/** Use it to create a new listener. You may want to get the listener retained for future use. */
+	static oListener* create(oEventId id, const oEventHandler& handler);
 	static oListener* create(const string& name, const oEventHandler& handler);
 protected:
-	oListener(const string& name, const oEventHandler& handler);
-	oListener(const string& name, int handler);
+	oListener(oEventId id, const oEventHandler& handler);
 	static const int INVALID_ORDER;
-	string _name;
+	oEventId _id;
 	int _order;
 	oEventHandler _handler;
 	friend class oEventType;
@@ -4,6 +4,9 @@
 #include <queue>
 #include <pthread.h>
 #include <semaphore.h>
+#if CC_TARGET_PLATFORM != CC_PLATFORM_WIN32
+#include <unistd.h>
+#endif
 using namespace std;
 
 NS_DOROTHY_BEGIN
@@ -178,4 +181,149 @@ void oAsync(const function<void*()>& worker, const function<void(void*)>& finish
 	oAsyncWorker::shared()->async(worker, finisher);
 }
 
+class oParallelWorker
+{
+public:
+	oParallelWorker():
+	_work(nullptr),
+	_count(0),
+	_next(0),
+	_chunk(1),
+	_running(0),
+	_generation(0),
+	_quit(false)
+	{
+		pthread_mutex_init(&_mutex, nullptr);
+		pthread_cond_init(&_startCond, nullptr);
+		pthread_cond_init(&_doneCond, nullptr);
+		int threadCount = MIN(oParallelWorker::getCoreCount() - 1, MAX_THREADS);
+		for (int i = 0; i < threadCount; i++)
+		{
+			pthread_t thread;
+			if (pthread_create(&thread, nullptr, oParallelWorker::run, this) == 0)
+			{
+				_threads.push_back(thread);
+			}
+		}
+	}
+	~oParallelWorker()
+	{
+		pthread_mutex_lock(&_mutex);
+		_quit = true;
+		pthread_cond_broadcast(&_startCond);
+		pthread_mutex_unlock(&_mutex);
+		for (pthread_t& thread : _threads)
+		{
+			pthread_join(thread, nullptr);
+		}
+		pthread_cond_destroy(&_startCond);
+		pthread_cond_destroy(&_doneCond);
+		pthread_mutex_destroy(&_mutex);
+	}
+	void parallel(int count, const function<void(int)>& work)
+	{
+		if (_threads.empty() || count < 2)
+		{
+			for (int i = 0; i < count; i++) work(i);
+			return;
+		}
+		pthread_mutex_lock(&_mutex);
+		_work = &work;
+		_count = count;
+		_next = 0;
+		/* hand out several chunks per thread to balance uneven work */
+		_chunk = MAX(1, count / ((int)(_threads.size() + 1) * 4));
+		_running = (int)_threads.size();
+		_generation++;
+		pthread_cond_broadcast(&_startCond);
+		pthread_mutex_unlock(&_mutex);
+		oParallelWorker::consume();
+		pthread_mutex_lock(&_mutex);
+		while (_running > 0)
+		{
+			pthread_cond_wait(&_doneCond, &_mutex);
+		}
+		_work = nullptr;
+		pthread_mutex_unlock(&_mutex);
+	}
+	static oParallelWorker& shared()
+	{
+		static oParallelWorker worker;
+		return worker;
+	}
+private:
+	enum { MAX_THREADS = 7 };
+	static int getCoreCount()
+	{
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return (int)info.dwNumberOfProcessors;
+#else
+		return (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	}
+	void consume()
+	{
+		while (true)
+		{
+			pthread_mutex_lock(&_mutex);
+			int begin = _next;
+			int end = MIN(begin + _chunk, _count);
+			_next = end;
+			const function<void(int)>* work = _work;
+			pthread_mutex_unlock(&_mutex);
+			if (begin >= end) break;
+			for (int i = begin; i < end; i++)
+			{
+				(*work)(i);
+			}
+		}
+	}
+	static void* run(void* data)
+	{
+		oParallelWorker* self = (oParallelWorker*)data;
+		unsigned int generation = 0;
+		while (true)
+		{
+			pthread_mutex_lock(&self->_mutex);
+			while (!self->_quit && generation == self->_generation)
+			{
+				pthread_cond_wait(&self->_startCond, &self->_mutex);
+			}
+			if (self->_quit)
+			{
+				pthread_mutex_unlock(&self->_mutex);
+				break;
+			}
+			generation = self->_generation;
+			pthread_mutex_unlock(&self->_mutex);
+			self->consume();
+			pthread_mutex_lock(&self->_mutex);
+			if (--self->_running == 0)
+			{
+				pthread_cond_signal(&self->_doneCond);
+			}
+			pthread_mutex_unlock(&self->_mutex);
+		}
+		return 0;
+	}
+	vector<pthread_t> _threads;
+	pthread_mutex_t _mutex;
+	pthread_cond_t _startCond;
+	pthread_cond_t _doneCond;
+	const function<void(int)>* _work;
+	int _count;
+	int _next;
+	int _chunk;
+	int _running;
+	unsigned int _generation;
+	bool _quit;
+};
+
+void oParallel(int count, const function<void(int)>& work)
+{
+	oParallelWorker::shared().parallel(count, work);
+}
+
 NS_DOROTHY_END
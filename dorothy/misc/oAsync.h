@@ -15,6 +15,12 @@ NS_DOROTHY_BEGIN
  finisher receives the result and runs in main program */
 void oAsync(const function<void*()>& worker, const function<void(void*)>& finisher);
 
+/* work is called with every index in [0, count) from the calling thread
+ and a pool of worker threads, returns when all indices are done.
+ work must not touch Lua or retain and release objects,
+ call it from the main thread only, it is not re-entrant. */
+void oParallel(int count, const function<void(int)>& work);
+
 NS_DOROTHY_END
 
 #endif // __DOROTHY_MISC_OASYNC_H__
\ No newline at end of file
@@ -0,0 +1,61 @@
+/* Copyright (c) 2013 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include "const/oDefine.h"
+#include "misc/oIdTable.h"
+
+NS_DOROTHY_BEGIN
+
+oIdTable::oIdTable()
+{
+	memset(_cache, 0, sizeof(_cache));
+}
+
+int oIdTable::getId( const string& name )
+{
+	auto it = _ids.find(name);
+	if (it != _ids.end())
+	{
+		return it->second;
+	}
+	int id = (int)_names.size();
+	_names.push_back(name);
+	_ids[name] = id;
+	return id;
+}
+
+int oIdTable::getId( const char* name )
+{
+	oCacheEntry& entry = _cache[((size_t)name >> 3) % CacheSize];
+	//The buffer may have been reused by another string, so compare the content as well.
+	if (entry.str == name && _names[entry.id] == name)
+	{
+		return entry.id;
+	}
+	entry.id = oIdTable::getId(string(name));
+	entry.str = name;
+	return entry.id;
+}
+
+int oIdTable::find( const string& name ) const
+{
+	auto it = _ids.find(name);
+	return it == _ids.end() ? -1 : it->second;
+}
+
+const string& oIdTable::getName( int id ) const
+{
+	return _names[id];
+}
+
+int oIdTable::getCount() const
+{
+	return (int)_names.size();
+}
+
+NS_DOROTHY_END
\ No newline at end of file
@@ -0,0 +1,42 @@
+/* Copyright (c) 2013 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#ifndef __DOROTHY_MISC_OIDTABLE_H__
+#define __DOROTHY_MISC_OIDTABLE_H__
+
+NS_DOROTHY_BEGIN
+
+/** @brief Interns names into dense integer ids starting from 0.
+ Lookups by const char* are cached by the string address,
+ since scripts pass the same buffer for the same name.
+*/
+class oIdTable
+{
+public:
+	oIdTable();
+	int getId(const string& name);
+	int getId(const char* name);
+	/** Get the id without interning, returns -1 when the name is unknown. */
+	int find(const string& name) const;
+	const string& getName(int id) const;
+	int getCount() const;
+private:
+	enum {CacheSize = 64};
+	struct oCacheEntry
+	{
+		const char* str;
+		int id;
+	};
+	unordered_map<string, int> _ids;
+	vector<string> _names;
+	oCacheEntry _cache[CacheSize];
+};
+
+NS_DOROTHY_END
+
+#endif // __DOROTHY_MISC_OIDTABLE_H__
\ No newline at end of file
@@ -0,0 +1,213 @@
+/* Copyright (c) 2013 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#ifndef __DOROTHY_MISC_OREFSET_H__
+#define __DOROTHY_MISC_OREFSET_H__
+
+#include "misc/oRef.h"
+
+NS_DOROTHY_BEGIN
+
+/** @brief Set of retained objects keyed by object id.
+ Items are kept in a flat array for iteration without retaining,
+ add, remove and contains cost O(1). Adding an item already in the set
+ increases its count, the item leaves the set once removed as many times.
+ Small sets are scanned linearly, an open addressing index
+ is built when the set grows larger.
+*/
+template<class T = CCObject>
+class oRefSet
+{
+public:
+	~oRefSet()
+	{
+		oRefSet::clear();
+	}
+	/** Return true when the item is newly added. */
+	bool add(T* item)
+	{
+		int index = oRefSet::indexOf(item);
+		if (index >= 0)
+		{
+			_counts[index]++;
+			return false;
+		}
+		item->retain();
+		_items.push_back(item);
+		_counts.push_back(1);
+		if (!_slots.empty())
+		{
+			oRefSet::insertSlot((int)_items.size() - 1);
+		}
+		else if (_items.size() > LINEAR_SIZE)
+		{
+			oRefSet::rehash();
+		}
+		return true;
+	}
+	/** Return true when the item is finally removed from the set. */
+	bool remove(T* item)
+	{
+		int slot = -1;
+		int index = -1;
+		if (_slots.empty())
+		{
+			index = oRefSet::linearIndexOf(item);
+		}
+		else
+		{
+			slot = oRefSet::slotOf(item);
+			index = slot < 0 ? -1 : _slots[slot];
+		}
+		if (index < 0 || --_counts[index] > 0)
+		{
+			return false;
+		}
+		int last = (int)_items.size() - 1;
+		if (slot >= 0)
+		{
+			oRefSet::eraseSlot(slot);
+			if (index != last)
+			{
+				_slots[oRefSet::slotOf(_items[last])] = index;
+			}
+		}
+		_items[index] = _items[last];
+		_counts[index] = _counts[last];
+		_items.pop_back();
+		_counts.pop_back();
+		if (_items.empty())
+		{
+			_slots.clear();
+		}
+		item->release();
+		return true;
+	}
+	bool contains(T* item) const
+	{
+		return oRefSet::indexOf(item) >= 0;
+	}
+	void clear()
+	{
+		vector<T*> items;
+		items.swap(_items);
+		_counts.clear();
+		_slots.clear();
+		for (T* item : items)
+		{
+			item->release();
+		}
+	}
+	inline int size() const
+	{
+		return (int)_items.size();
+	}
+	inline bool empty() const
+	{
+		return _items.empty();
+	}
+	inline T* operator[](int index) const
+	{
+		return _items[index];
+	}
+	/** Items are not retained by the returned list,
+	 do not keep the list while the set is modified. */
+	inline const vector<T*>& items() const
+	{
+		return _items;
+	}
+	inline typename vector<T*>::const_iterator begin() const
+	{
+		return _items.begin();
+	}
+	inline typename vector<T*>::const_iterator end() const
+	{
+		return _items.end();
+	}
+private:
+	enum { LINEAR_SIZE = 8, EMPTY = -1 };
+	static inline unsigned int hash(T* item)
+	{
+		return item->getObjectId() * 2654435761u;
+	}
+	inline int mask() const
+	{
+		return (int)_slots.size() - 1;
+	}
+	int linearIndexOf(T* item) const
+	{
+		for (int i = 0; i < (int)_items.size(); i++)
+		{
+			if (_items[i] == item) return i;
+		}
+		return -1;
+	}
+	int slotOf(T* item) const
+	{
+		for (int slot = hash(item) & mask(); _slots[slot] != EMPTY; slot = (slot + 1) & mask())
+		{
+			if (_items[_slots[slot]] == item) return slot;
+		}
+		return -1;
+	}
+	int indexOf(T* item) const
+	{
+		if (_slots.empty())
+		{
+			return oRefSet::linearIndexOf(item);
+		}
+		int slot = oRefSet::slotOf(item);
+		return slot < 0 ? -1 : _slots[slot];
+	}
+	void insertSlot(int index)
+	{
+		if ((int)_items.size() * 2 > (int)_slots.size())
+		{
+			oRefSet::rehash();
+			return;
+		}
+		int slot = hash(_items[index]) & mask();
+		for (; _slots[slot] != EMPTY; slot = (slot + 1) & mask());
+		_slots[slot] = index;
+	}
+	/* backward shift deletion keeps linear probing chains without tombstones */
+	void eraseSlot(int slot)
+	{
+		int hole = slot;
+		for (int next = (hole + 1) & mask(); _slots[next] != EMPTY; next = (next + 1) & mask())
+		{
+			int home = hash(_items[_slots[next]]) & mask();
+			bool movable = hole <= next ? (home <= hole || home > next) : (home <= hole && home > next);
+			if (movable)
+			{
+				_slots[hole] = _slots[next];
+				hole = next;
+			}
+		}
+		_slots[hole] = EMPTY;
+	}
+	void rehash()
+	{
+		int capacity = LINEAR_SIZE * 4;
+		while (capacity < (int)_items.size() * 4) capacity *= 2;
+		_slots.assign(capacity, EMPTY);
+		for (int i = 0; i < (int)_items.size(); i++)
+		{
+			int slot = hash(_items[i]) & mask();
+			for (; _slots[slot] != EMPTY; slot = (slot + 1) & mask());
+			_slots[slot] = i;
+		}
+	}
+	vector<T*> _items;
+	vector<int> _counts;
+	vector<int> _slots;
+};
+
+NS_DOROTHY_END
+
+#endif // __DOROTHY_MISC_OREFSET_H__
@@ -0,0 +1,234 @@
+/* Copyright (c) 2013 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include "const/oDefine.h"
+#include "misc/oSizePool.h"
+
+NS_DOROTHY_BEGIN
+
+static const size_t g_classSizes[oSizePool::ClassCount] =
+{
+	8, 16, 24, 32, 48, 64, 80, 96, 128, 160, 192, 256
+};
+
+static int g_classIndex[oSizePool::MaxClassSize / 8 + 1];
+
+static bool oInitClassIndex()
+{
+	int index = 0;
+	for (int i = 0; i <= oSizePool::MaxClassSize / 8; i++)
+	{
+		while (g_classSizes[index] < (size_t)i * 8) index++;
+		g_classIndex[i] = index;
+	}
+	return true;
+}
+
+static bool g_classIndexReady = oInitClassIndex();
+
+oSizePool::oSizePool():
+_largeBlocks(nullptr),
+_largeCount(0),
+_largeAllocs(0),
+_largeBytes(0),
+_capacity(0)
+{
+	memset(_classes, 0, sizeof(_classes));
+}
+
+oSizePool::~oSizePool()
+{
+	oSizePool::reset();
+}
+
+int oSizePool::getClass(size_t size)
+{
+	return size > MaxClassSize ? ClassCount : g_classIndex[(size + 7) >> 3];
+}
+
+void* oSizePool::alloc(size_t size)
+{
+	int index = oSizePool::getClass(size);
+	if (index == ClassCount)
+	{
+		return oSizePool::allocLarge(size);
+	}
+	SizeClass& sizeClass = _classes[index];
+	sizeClass.count++;
+	sizeClass.allocs++;
+	if (sizeClass.freeList)
+	{
+		FreeList* head = sizeClass.freeList;
+		sizeClass.freeList = head->next;
+		return (void*)head;
+	}
+	size_t itemSize = g_classSizes[index];
+	Chunk* chunk = sizeClass.chunk;
+	if (!chunk || chunk->size + itemSize > ChunkCapacity)
+	{
+		chunk = (Chunk*)::malloc(sizeof(Chunk) + ChunkCapacity);
+		if (!chunk)
+		{
+			sizeClass.count--;
+			sizeClass.allocs--;
+			return nullptr;
+		}
+		chunk->next = sizeClass.chunk;
+		chunk->size = 0;
+		sizeClass.chunk = chunk;
+		_capacity += ChunkCapacity;
+	}
+	char* addr = (char*)(chunk + 1) + chunk->size;
+	chunk->size += itemSize;
+	return (void*)addr;
+}
+
+void oSizePool::free(void* addr, size_t size)
+{
+	int index = oSizePool::getClass(size);
+	if (index == ClassCount)
+	{
+		oSizePool::freeLarge(addr);
+		_largeBytes -= size;
+		return;
+	}
+	SizeClass& sizeClass = _classes[index];
+	FreeList* freeItem = (FreeList*)addr;
+	freeItem->next = sizeClass.freeList;
+	sizeClass.freeList = freeItem;
+	sizeClass.count--;
+}
+
+void* oSizePool::realloc(void* addr, size_t oldSize, size_t newSize)
+{
+	int oldIndex = oSizePool::getClass(oldSize);
+	int newIndex = oSizePool::getClass(newSize);
+	if (oldIndex == newIndex && oldIndex != ClassCount)
+	{
+		return addr;
+	}
+	if (oldIndex == ClassCount && newIndex == ClassCount)
+	{
+		LargeBlock* block = (LargeBlock*)addr - 1;
+		LargeBlock* prev = block->prev;
+		LargeBlock* next = block->next;
+		block = (LargeBlock*)::realloc(block, sizeof(LargeBlock) + newSize);
+		if (!block) return nullptr;
+		if (prev) prev->next = block;
+		else _largeBlocks = block;
+		if (next) next->prev = block;
+		_largeBytes += newSize - oldSize;
+		_largeAllocs++;
+		return (void*)(block + 1);
+	}
+	void* newAddr = oSizePool::alloc(newSize);
+	if (!newAddr) return nullptr;
+	memcpy(newAddr, addr, MIN(oldSize, newSize));
+	oSizePool::free(addr, oldSize);
+	return newAddr;
+}
+
+void* oSizePool::allocLarge(size_t size)
+{
+	LargeBlock* block = (LargeBlock*)::malloc(sizeof(LargeBlock) + size);
+	if (!block) return nullptr;
+	block->prev = nullptr;
+	block->next = _largeBlocks;
+	if (_largeBlocks) _largeBlocks->prev = block;
+	_largeBlocks = block;
+	_largeCount++;
+	_largeAllocs++;
+	_largeBytes += size;
+	return (void*)(block + 1);
+}
+
+void oSizePool::freeLarge(void* addr)
+{
+	LargeBlock* block = (LargeBlock*)addr - 1;
+	if (block->prev) block->prev->next = block->next;
+	else _largeBlocks = block->next;
+	if (block->next) block->next->prev = block->prev;
+	_largeCount--;
+	::free(block);
+}
+
+void oSizePool::reset()
+{
+	for (int i = 0; i < ClassCount; i++)
+	{
+		for (Chunk* chunk = _classes[i].chunk; chunk;)
+		{
+			Chunk* next = chunk->next;
+			::free(chunk);
+			chunk = next;
+		}
+	}
+	memset(_classes, 0, sizeof(_classes));
+	for (LargeBlock* block = _largeBlocks; block;)
+	{
+		LargeBlock* next = block->next;
+		::free(block);
+		block = next;
+	}
+	_largeBlocks = nullptr;
+	_largeCount = 0;
+	_largeAllocs = 0;
+	_largeBytes = 0;
+	_capacity = 0;
+}
+
+size_t oSizePool::getClassSize(int index)
+{
+	return index < ClassCount ? g_classSizes[index] : 0;
+}
+
+int oSizePool::getCount(int index) const
+{
+	return index < ClassCount ? _classes[index].count : _largeCount;
+}
+
+int oSizePool::getAllocs(int index) const
+{
+	return index < ClassCount ? _classes[index].allocs : _largeAllocs;
+}
+
+size_t oSizePool::getBytes(int index) const
+{
+	return index < ClassCount ? _classes[index].count * g_classSizes[index] : _largeBytes;
+}
+
+size_t oSizePool::getCapacity() const
+{
+	return _capacity;
+}
+
+void oSizePool::resetStats()
+{
+	for (int i = 0; i < ClassCount; i++)
+	{
+		_classes[i].allocs = 0;
+	}
+	_largeAllocs = 0;
+}
+
+void* oSizePool::luaAlloc(void* ud, void* ptr, size_t osize, size_t nsize)
+{
+	oSizePool* pool = (oSizePool*)ud;
+	if (nsize == 0)
+	{
+		if (ptr) pool->free(ptr, osize);
+		return nullptr;
+	}
+	if (!ptr)
+	{
+		return pool->alloc(nsize);
+	}
+	return pool->realloc(ptr, osize, nsize);
+}
+
+NS_DOROTHY_END
\ No newline at end of file
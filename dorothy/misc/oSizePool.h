@@ -0,0 +1,83 @@
+/* Copyright (c) 2013 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#ifndef __DOROTHY_MISC_OSIZEPOOL_H__
+#define __DOROTHY_MISC_OSIZEPOOL_H__
+
+NS_DOROTHY_BEGIN
+
+/** @brief Memory pool of oMemoryPool style free lists, one for each size class.
+ The caller passes the block size back on free and realloc the way lua_Alloc does,
+ so blocks carry no header. Blocks larger than the biggest class go to malloc.
+ A pool is not thread-safe, give each thread or each Lua state its own pool.
+*/
+class oSizePool
+{
+public:
+	enum
+	{
+		ClassCount = 12,
+		MaxClassSize = 256,
+		ChunkCapacity = 16384
+	};
+	oSizePool();
+	~oSizePool();
+	void* alloc(size_t size);
+	void free(void* addr, size_t size);
+	void* realloc(void* addr, size_t oldSize, size_t newSize);
+	/** Drop every block at once, only when nothing allocated from the pool is in use. */
+	void reset();
+	/** Size of a class, index ClassCount stands for the blocks larger than MaxClassSize. */
+	static size_t getClassSize(int index);
+	/** Blocks in use for a class. */
+	int getCount(int index) const;
+	/** Allocations made for a class since the last resetStats. */
+	int getAllocs(int index) const;
+	/** Bytes in use for a class. */
+	size_t getBytes(int index) const;
+	/** Bytes held by the chunks of all classes. */
+	size_t getCapacity() const;
+	void resetStats();
+	/** An allocator with the lua_Alloc signature, the ud is the pool. */
+	static void* luaAlloc(void* ud, void* ptr, size_t osize, size_t nsize);
+private:
+	struct FreeList
+	{
+		FreeList* next;
+	};
+	struct Chunk
+	{
+		Chunk* next;
+		size_t size;
+	};
+	struct LargeBlock
+	{
+		LargeBlock* prev;
+		LargeBlock* next;
+	};
+	struct SizeClass
+	{
+		FreeList* freeList;
+		Chunk* chunk;
+		int count;
+		int allocs;
+	};
+	static int getClass(size_t size);
+	void* allocLarge(size_t size);
+	void freeLarge(void* addr);
+	SizeClass _classes[ClassCount];
+	LargeBlock* _largeBlocks;
+	int _largeCount;
+	int _largeAllocs;
+	size_t _largeBytes;
+	size_t _capacity;
+};
+
+NS_DOROTHY_END
+
+#endif // __DOROTHY_MISC_OSIZEPOOL_H__
\ No newline at end of file
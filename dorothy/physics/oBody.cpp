@@ -53,9 +53,21 @@ bool oBody::init()
 		}
 		else
 		{
-			oBody::attachFixture(fixtureDef);
+			/* mass data is summed up once below instead of
+			 resetting it for each dense fixture */
+			float density = fixtureDef->density;
+			fixtureDef->density = 0.0f;
+			b2Fixture* fixture = oBody::attachFixture(fixtureDef);
+			fixtureDef->density = density;
+			fixture->SetDensity(density);
 		}
 	}
+	if (_bodyB2->GetType() == b2_dynamicBody)
+	{
+		b2MassData massData;
+		_bodyDef->getMassData(&massData);
+		_bodyB2->SetMassData(&massData);
+	}
 	return true;
 }
 
@@ -143,6 +155,7 @@ bool oBody::removeSensor( oSensor* sensor )
 {
 	if (_sensors && sensor && sensor->getFixture()->GetBody() == _bodyB2)
 	{
+		_world->removeFixture(sensor->getFixture());
 		_bodyB2->DestroyFixture(sensor->getFixture());
 		_sensors->removeObject(sensor);
 		return true;
@@ -215,7 +228,7 @@ void oBody::setGroup( int group )
 	_group = group;
 	for (b2Fixture* f = _bodyB2->GetFixtureList();f;f = f->GetNext())
 	{
-		f->SetFilterData(_world->getFilter(group));
+		_world->setFixtureGroup(f, group);
 	}
 }
 
@@ -239,6 +252,7 @@ b2Fixture* oBody::attachFixture(b2FixtureDef* fixtureDef)
 	fixtureDef->filter = _world->getFilter(_group);
 	fixtureDef->isSensor = false;
 	b2Fixture* fixture = _bodyB2->CreateFixture(fixtureDef);
+	_world->addFixture(fixture);
 	return fixture;
 }
 
@@ -259,6 +273,7 @@ oSensor* oBody::attachSensor( int tag, b2FixtureDef* fixtureDef )
 	fixtureDef->filter = _world->getFilter(_group);
 	fixtureDef->isSensor = true;
 	b2Fixture* fixture = _bodyB2->CreateFixture(fixtureDef);
+	_world->addFixture(fixture);
 	oSensor* sensor = oSensor::create(this, tag, fixture);
 	fixture->SetUserData((void*)sensor);
 	if (!_sensors) _sensors = CCArray::create();
@@ -18,6 +18,92 @@ b2CircleShape oBodyDef::_circleShape;
 b2PolygonShape oBodyDef::_polygenShape;
 b2FixtureDef oBodyDef::_fixtureDef;
 
+/* shapes are immutable once interned, every body def
+ attaching the same geometry shares one prototype */
+static unordered_map<string, oShapePrototype*>& sharedPrototypes()
+{
+	/* never freed, body defs may be released after static destruction */
+	static auto prototypes = new unordered_map<string, oShapePrototype*>();
+	return *prototypes;
+}
+
+static void appendKey(string& key, const void* data, size_t size)
+{
+	key.append((const char*)data, size);
+}
+
+static string shapeKey(const b2Shape* shape)
+{
+	string key;
+	appendKey(key, &shape->m_type, sizeof(shape->m_type));
+	appendKey(key, &shape->m_radius, sizeof(shape->m_radius));
+	switch (shape->m_type)
+	{
+	case b2Shape::e_circle:
+	{
+		const b2CircleShape* circle = (const b2CircleShape*)shape;
+		appendKey(key, &circle->m_p, sizeof(b2Vec2));
+		break;
+	}
+	case b2Shape::e_polygon:
+	{
+		const b2PolygonShape* polygon = (const b2PolygonShape*)shape;
+		appendKey(key, &polygon->m_count, sizeof(polygon->m_count));
+		appendKey(key, polygon->m_vertices, sizeof(b2Vec2) * polygon->m_count);
+		break;
+	}
+	case b2Shape::e_chain:
+	{
+		const b2ChainShape* chain = (const b2ChainShape*)shape;
+		appendKey(key, &chain->m_count, sizeof(chain->m_count));
+		appendKey(key, chain->m_vertices, sizeof(b2Vec2) * chain->m_count);
+		appendKey(key, &chain->m_hasPrevVertex, sizeof(bool));
+		appendKey(key, &chain->m_hasNextVertex, sizeof(bool));
+		appendKey(key, &chain->m_prevVertex, sizeof(b2Vec2));
+		appendKey(key, &chain->m_nextVertex, sizeof(b2Vec2));
+		break;
+	}
+	default:
+		break;
+	}
+	return key;
+}
+
+oShapePrototype* oShapePrototype::intern(b2Shape* shape)
+{
+	string key = shapeKey(shape);
+	auto& prototypes = sharedPrototypes();
+	auto it = prototypes.find(key);
+	if (it != prototypes.end())
+	{
+		delete shape;
+		it->second->_refCount++;
+		return it->second;
+	}
+	oShapePrototype* prototype = new oShapePrototype();
+	prototype->_shape = shape;
+	prototype->_key = key;
+	prototype->_refCount = 1;
+	shape->ComputeMass(&prototype->_unitMass, 1.0f);
+	prototypes[key] = prototype;
+	return prototype;
+}
+
+void oShapePrototype::release()
+{
+	if (--_refCount == 0)
+	{
+		sharedPrototypes().erase(_key);
+		delete _shape;
+		delete this;
+	}
+}
+
+int oShapePrototype::getCount()
+{
+	return (int)sharedPrototypes().size();
+}
+
 oBodyDef::oBodyDef():
 angleOffset(0)
 {
@@ -36,23 +122,13 @@ void oBodyDef::attachPolygon( const oVec2& center, float width, float height, fl
 		oWorld::b2Val(height * 0.5f),
 		oWorld::b2Val(center),
 		-CC_DEGREES_TO_RADIANS(angle));
-	b2FixtureDef* fixtureDef = new b2FixtureDef();
-	fixtureDef->shape = shape;
-	fixtureDef->density = density;
-	fixtureDef->friction = friction;
-	fixtureDef->restitution = restitution;
-	_fixtureDefs.push_back(fixtureDef);
+	oBodyDef::attachShape(shape, density, friction, restitution);
 }
 void oBodyDef::attachPolygon( float width, float height, float density, float friction, float restitution )
 {
 	b2PolygonShape* shape = new b2PolygonShape();
 	shape->SetAsBox(oWorld::b2Val(width * 0.5f), oWorld::b2Val(height * 0.5f));
-	b2FixtureDef* fixtureDef = new b2FixtureDef();
-	fixtureDef->shape = shape;
-	fixtureDef->density = density;
-	fixtureDef->friction = friction;
-	fixtureDef->restitution = restitution;
-	_fixtureDefs.push_back(fixtureDef);
+	oBodyDef::attachShape(shape, density, friction, restitution);
 }
 void oBodyDef::attachPolygon( const vector<oVec2>& vertices, float density, float friction, float restitution )
 {
@@ -61,15 +137,10 @@ void oBodyDef::attachPolygon( const vector<oVec2>& vertices, float density, floa
 	b2Vec2 vs[b2_maxPolygonVertices];
 	for (int i = 0; i < length; i++)
 	{
-	vs[i] = oWorld::b2Val(vertices[i]);
+		vs[i] = oWorld::b2Val(vertices[i]);
 	}
 	shape->Set(vs, length);
-	b2FixtureDef* fixtureDef = new b2FixtureDef();
-	fixtureDef->shape = shape;
-	fixtureDef->density = density;
-	fixtureDef->friction = friction;
-	fixtureDef->restitution = restitution;
-	_fixtureDefs.push_back(fixtureDef);
+	oBodyDef::attachShape(shape, density, friction, restitution);
 }
 void oBodyDef::attachPolygon( const oVec2 vertices[], int count, float density, float friction, float restitution )
 {
@@ -81,12 +152,7 @@ void oBodyDef::attachPolygon( const oVec2 vertices[], int count, float density,
 		vs[i] = oWorld::b2Val(vertices[i]);
 	}
 	shape->Set(vs, count);
-	b2FixtureDef* fixtureDef = new b2FixtureDef();
-	fixtureDef->shape = shape;
-	fixtureDef->density = density;
-	fixtureDef->friction = friction;
-	fixtureDef->restitution = restitution;
-	_fixtureDefs.push_back(fixtureDef);
+	oBodyDef::attachShape(shape, density, friction, restitution);
 }
 void oBodyDef::attachLoop( const vector<oVec2>& vertices, float friction, float restitution )
 {
@@ -99,11 +165,7 @@ void oBodyDef::attachLoop( const vector<oVec2>& vertices, float friction, float
 	}
 	shape->CreateLoop(vs, length);
 	delete [] vs;
-	b2FixtureDef* fixtureDef = new b2FixtureDef();
-	fixtureDef->shape = shape;
-	fixtureDef->friction = friction;
-	fixtureDef->restitution = restitution;
-	_fixtureDefs.push_back(fixtureDef);
+	oBodyDef::attachShape(shape, 0.0f, friction, restitution);
 }
 void oBodyDef::attachLoop( const oVec2 vertices[], int count, float friction, float restitution)
 {
@@ -115,23 +177,14 @@ void oBodyDef::attachLoop( const oVec2 vertices[], int count, float friction, fl
 	}
 	shape->CreateLoop(vs, count);
 	delete[] vs;
-	b2FixtureDef* fixtureDef = new b2FixtureDef();
-	fixtureDef->shape = shape;
-	fixtureDef->friction = friction;
-	fixtureDef->restitution = restitution;
-	_fixtureDefs.push_back(fixtureDef);
+	oBodyDef::attachShape(shape, 0.0f, friction, restitution);
 }
 void oBodyDef::attachCircle( const oVec2& center, float radius, float density, float friction, float restitution )
 {
 	b2CircleShape* shape = new b2CircleShape();
 	shape->m_p = oWorld::b2Val(center);
 	shape->m_radius = oWorld::b2Val(radius);
-	b2FixtureDef* fixtureDef = new b2FixtureDef();
-	fixtureDef->shape = shape;
-	fixtureDef->density = density;
-	fixtureDef->friction = friction;
-	fixtureDef->restitution = restitution;
-	_fixtureDefs.push_back(fixtureDef);
+	oBodyDef::attachShape(shape, density, friction, restitution);
 }
 void oBodyDef::attachCircle( float radius, float density, float friction, float restitution )
 {
@@ -148,11 +201,7 @@ void oBodyDef::attachChain( const vector<oVec2>& vertices, float friction, float
 	}
 	shape->CreateChain(vs, length);
 	delete [] vs;
-	b2FixtureDef* fixtureDef = new b2FixtureDef();
-	fixtureDef->shape = shape;
-	fixtureDef->friction = friction;
-	fixtureDef->restitution = restitution;
-	_fixtureDefs.push_back(fixtureDef);
+	oBodyDef::attachShape(shape, 0.0f, friction, restitution);
 }
 void oBodyDef::attachChain(const oVec2 vertices[], int count, float friction, float restitution)
 {
@@ -164,11 +213,28 @@ void oBodyDef::attachChain(const oVec2 vertices[], int count, float friction, fl
 	}
 	shape->CreateChain(vs, count);
 	delete[] vs;
+	oBodyDef::attachShape(shape, 0.0f, friction, restitution);
+}
+void oBodyDef::attachShape( b2Shape* shape, float density, float friction, float restitution )
+{
+	oShapePrototype* prototype = oShapePrototype::intern(shape);
 	b2FixtureDef* fixtureDef = new b2FixtureDef();
-	fixtureDef->shape = shape;
+	fixtureDef->shape = prototype->getShape();
+	fixtureDef->density = density;
 	fixtureDef->friction = friction;
 	fixtureDef->restitution = restitution;
 	_fixtureDefs.push_back(fixtureDef);
+	_prototypes.push_back(prototype);
+}
+void oBodyDef::attachSensorShape( int tag, b2Shape* shape )
+{
+	oShapePrototype* prototype = oShapePrototype::intern(shape);
+	b2FixtureDef* fixtureDef = new b2FixtureDef();
+	fixtureDef->shape = prototype->getShape();
+	fixtureDef->isSensor = true;
+	fixtureDef->userData = (void*)(long)tag;
+	_fixtureDefs.push_back(fixtureDef);
+	_prototypes.push_back(prototype);
 }
 void oBodyDef::attachPolygonSensor( int tag, float width, float height )
 {
@@ -181,11 +247,7 @@ void oBodyDef::attachPolygonSensor( int tag, float width, float height, const oV
 		oWorld::b2Val(height * 0.5f),
 		oWorld::b2Val(center),
 		-CC_DEGREES_TO_RADIANS(angle));
-	b2FixtureDef* fixtureDef = new b2FixtureDef();
-	fixtureDef->shape = shape;
-	fixtureDef->isSensor = true;
-	fixtureDef->userData = (void*)(long)tag;
-	_fixtureDefs.push_back(fixtureDef);
+	oBodyDef::attachSensorShape(tag, shape);
 }
 void oBodyDef::attachPolygonSensor( int tag, const vector<oVec2>& vertices )
 {
@@ -197,11 +259,7 @@ void oBodyDef::attachPolygonSensor( int tag, const vector<oVec2>& vertices )
 		vs[i] = oWorld::b2Val(vertices[i]);
 	}
 	shape->Set(vs, length);
-	b2FixtureDef* fixtureDef = new b2FixtureDef();
-	fixtureDef->shape = shape;
-	fixtureDef->isSensor = true;
-	fixtureDef->userData = (void*)(long)tag;
-	_fixtureDefs.push_back(fixtureDef);
+	oBodyDef::attachSensorShape(tag, shape);
 }
 void oBodyDef::attachPolygonSensor(int tag, const oVec2 vertices[], int count)
 {
@@ -212,22 +270,14 @@ void oBodyDef::attachPolygonSensor(int tag, const oVec2 vertices[], int count)
 		vs[i] = oWorld::b2Val(vertices[i]);
 	}
 	shape->Set(vs, count);
-	b2FixtureDef* fixtureDef = new b2FixtureDef();
-	fixtureDef->shape = shape;
-	fixtureDef->isSensor = true;
-	fixtureDef->userData = (void*)(long)tag;
-	_fixtureDefs.push_back(fixtureDef);
+	oBodyDef::attachSensorShape(tag, shape);
 }
 void oBodyDef::attachCircleSensor( int tag, const oVec2& center, float radius )
 {
 	b2CircleShape* shape = new b2CircleShape();
 	shape->m_p = oWorld::b2Val(center);
 	shape->m_radius = oWorld::b2Val(radius);
-	b2FixtureDef* fixtureDef = new b2FixtureDef();
-	fixtureDef->shape = shape;
-	fixtureDef->isSensor = true;
-	fixtureDef->userData = (void*)(long)tag;
-	_fixtureDefs.push_back(fixtureDef);
+	oBodyDef::attachSensorShape(tag, shape);
 }
 void oBodyDef::attachCircleSensor( int tag, float radius )
 {
@@ -373,14 +423,38 @@ const oOwnVector<b2FixtureDef>& oBodyDef::getFixtureDefs() const
 
 void oBodyDef::clearFixtures()
 {
-	for (b2FixtureDef* fixtureDef : _fixtureDefs)
+	for (oShapePrototype* prototype : _prototypes)
 	{
-		delete fixtureDef->shape;
-		fixtureDef->shape = nullptr;
+		prototype->release();
 	}
+	_prototypes.clear();
 	_fixtureDefs.clear();
 }
 
+void oBodyDef::getMassData( b2MassData* massData ) const
+{
+	massData->mass = 0.0f;
+	massData->center.SetZero();
+	massData->I = 0.0f;
+	for (size_t i = 0; i < _fixtureDefs.size(); i++)
+	{
+		b2FixtureDef* fixtureDef = _fixtureDefs[i];
+		if (fixtureDef->isSensor || fixtureDef->density == 0.0f)
+		{
+			continue;
+		}
+		const b2MassData& unitMass = _prototypes[i]->getUnitMass();
+		float mass = unitMass.mass * fixtureDef->density;
+		massData->mass += mass;
+		massData->center += mass * unitMass.center;
+		massData->I += unitMass.I * fixtureDef->density;
+	}
+	if (massData->mass > 0.0f)
+	{
+		massData->center *= 1.0f / massData->mass;
+	}
+}
+
 void oBodyDef::setDensity(float var)
 {
 	for (b2FixtureDef* fixtureDef : _fixtureDefs)
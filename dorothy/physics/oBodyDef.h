@@ -14,6 +14,28 @@ NS_DOROTHY_BEGIN
 class oBody;
 class oWorld;
 
+/** @brief Immutable shape shared between fixture defs with the same geometry.
+ Mass data for unit density is computed once when the shape is interned.
+*/
+class oShapePrototype
+{
+public:
+	/** Take the shape and return the prototype of the same geometry,
+	 the shape is deleted when an existing prototype is found. */
+	static oShapePrototype* intern(b2Shape* shape);
+	void release();
+	inline const b2Shape* getShape() const { return _shape; }
+	inline const b2MassData& getUnitMass() const { return _unitMass; }
+	/** Get the number of interned prototypes. */
+	static int getCount();
+private:
+	oShapePrototype() { }
+	b2Shape* _shape;
+	b2MassData _unitMass;
+	string _key;
+	int _refCount;
+};
+
 class oBodyDef: public b2BodyDef, public CCObject
 {
 public:
@@ -162,6 +184,11 @@ public:
 	oVec2 facePos;
 	PROPERTY_READONLY_REF(oOwnVector<b2FixtureDef>, FixtureDefs);
 	void clearFixtures();
+	/**
+	 Get the mass data of all dense fixtures, the same as the one
+	 b2Body::ResetMassData() computes for a body made from this def.
+	 */
+	void getMassData(b2MassData* massData) const;
 	void setDensity(float var);
 	void setFriction(float var);
 	void setRestitution(float var);
@@ -173,7 +200,10 @@ protected:
 	static b2CircleShape _circleShape;
 	static b2ChainShape _chainShape;
 private:
+	void attachShape(b2Shape* shape, float density, float friction, float restitution);
+	void attachSensorShape(int tag, b2Shape* shape);
 	oOwnVector<b2FixtureDef> _fixtureDefs;
+	vector<oShapePrototype*> _prototypes;
 	CC_LUA_TYPE(oBodyDef)
 };
 
@@ -17,8 +17,7 @@ oSensor::oSensor(oBody* owner, int tag, b2Fixture* fixture):
 _owner(owner),
 _tag(tag),
 _fixture(fixture),
-_enabled(true),
-_sensedBodies(CCArray::create())
+_enabled(true)
 { }
 
 oSensor::~oSensor()
@@ -29,7 +28,11 @@ oSensor::~oSensor()
 
 void oSensor::add( oBody* body )
 {
-	_sensedBodies->addObject(body);
+	if (!_sensedBodies.add(body))
+	{
+		return;
+	}
+	_sensedArray = nullptr;
 	if (bodyEnter)
 	{
 		bodyEnter(this, body);
@@ -38,33 +41,43 @@ void oSensor::add( oBody* body )
 
 void oSensor::remove( oBody* body )
 {
-	if (_sensedBodies->fastRemoveObject(body) && bodyLeave)
+	if (_sensedBodies.remove(body))
 	{
-		bodyLeave(this, body);
+		_sensedArray = nullptr;
+		if (bodyLeave)
+		{
+			bodyLeave(this, body);
+		}
 	}
 }
 
 bool oSensor::contains( oBody* body )
 {
-	CCARRAY_START(oBody, item, _sensedBodies)
-	{
-		if (item == body)
-		{
-			return true;
-		}
-	}
-	CCARRAY_END
-	return false;
+	return _sensedBodies.contains(body);
 }
 
 void oSensor::clear()
 {
-	_sensedBodies->removeAllObjects();
+	_sensedBodies.clear();
+	_sensedArray = nullptr;
 }
 
 CCArray* oSensor::getSensedBodies() const
 {
-	return _sensedBodies;
+	if (!_sensedArray)
+	{
+		_sensedArray = CCArray::createWithCapacity(_sensedBodies.size());
+		for (oBody* body : _sensedBodies)
+		{
+			_sensedArray->addObject(body);
+		}
+	}
+	return _sensedArray;
+}
+
+const vector<oBody*>& oSensor::getSensedBodyList() const
+{
+	return _sensedBodies.items();
 }
 
 void oSensor::setEnabled( bool enable )
@@ -88,7 +101,7 @@ int oSensor::getTag() const
 
 void oSensor::setGroup(int var)
 {
-	_fixture->SetFilterData(_owner->getWorld()->getFilter(var));
+	_owner->getWorld()->setFixtureGroup(_fixture, var);
 }
 
 int oSensor::getGroup() const
@@ -116,7 +129,7 @@ oSensor* oSensor::create( oBody* owner, int tag, b2Fixture* fixture )
 
 bool oSensor::isSensed() const
 {
-	return _sensedBodies->count() > 0;
+	return !_sensedBodies.empty();
 }
 
 NS_DOROTHY_END
@@ -9,6 +9,8 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #ifndef __DOROTHY_PHYSICS_OSENSOR_H__
 #define __DOROTHY_PHYSICS_OSENSOR_H__
 
+#include "misc/oRefSet.h"
+
 NS_DOROTHY_BEGIN
 
 class oBody;
@@ -27,7 +29,15 @@ public:
 	PROPERTY_READONLY(int, Tag);
 	PROPERTY_READONLY(oBody*, Owner);
 	PROPERTY_READONLY(b2Fixture*, Fixture);
+	/**
+	 Get a copy of the sensed bodies as an array, used by scripts.
+	 */
 	PROPERTY_READONLY(CCArray*, SensedBodies);
+	/**
+	 Get sensed bodies without retaining them,
+	 do not keep the list after a physics step.
+	 */
+	const vector<oBody*>& getSensedBodyList() const;
 	PROPERTY_NAME(int, Group);
 	bool isSensed() const;
 	bool contains(oBody* body);
@@ -54,7 +64,8 @@ private:
 	void add(oBody* body);
 	void remove(oBody* body);
 	void clear();
-	oRef<CCArray> _sensedBodies;
+	oRefSet<oBody> _sensedBodies;
+	mutable oRef<CCArray> _sensedArray;
 	friend class oContactListener;
 	CC_LUA_TYPE(oSensor)
 };
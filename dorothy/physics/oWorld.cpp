@@ -44,7 +44,7 @@ void oContactListener::oContactPair::release()
 void oWorld::oQueryAABB::setInfo(const CCRect& rc)
 {
 	transform.Set(b2Vec2(b2Val(rc.getCenterX()), b2Val(rc.getCenterY())), 0);
-	testShape.SetAsBox(b2Val(rc.size.width), b2Val(rc.size.height));
+	testShape.SetAsBox(b2Val(rc.size.width * 0.5f), b2Val(rc.size.height * 0.5f));
 }
 bool oWorld::oQueryAABB::ReportFixture( b2Fixture* fixture )
 {
@@ -65,6 +65,92 @@ bool oWorld::oQueryAABB::ReportFixture( b2Fixture* fixture )
 	return true;
 }
 
+void oWorld::oQueryBatch::setInfo(const CCRect rects[], int count)
+{
+	_testShapes.resize(count);
+	_transforms.resize(count);
+	_aabbs.resize(count);
+	for (int i = 0; i < count; i++)
+	{
+		const CCRect& rc = rects[i];
+		_transforms[i].Set(b2Vec2(b2Val(rc.getCenterX()), b2Val(rc.getCenterY())), 0);
+		_testShapes[i].SetAsBox(b2Val(rc.size.width * 0.5f), b2Val(rc.size.height * 0.5f));
+		_aabbs[i].lowerBound.Set(b2Val(rc.getLeft()), b2Val(rc.getBottom()));
+		_aabbs[i].upperBound.Set(b2Val(rc.getRight()), b2Val(rc.getTop()));
+	}
+	_first = 0;
+	_last = count;
+	_reported.clear();
+}
+
+void oWorld::oQueryBatch::setRange(int first, int last)
+{
+	_first = first;
+	_last = last;
+}
+
+b2AABB oWorld::oQueryBatch::getRangeAABB() const
+{
+	b2AABB aabb = _aabbs[_first];
+	for (int i = _first + 1; i < _last; i++)
+	{
+		aabb.Combine(_aabbs[i]);
+	}
+	return aabb;
+}
+
+float oWorld::oQueryBatch::getRangeArea() const
+{
+	float area = 0.0f;
+	for (int i = _first; i < _last; i++)
+	{
+		b2Vec2 extents = _aabbs[i].GetExtents();
+		area += extents.x * extents.y * 4.0f;
+	}
+	return area;
+}
+
+bool oWorld::oQueryBatch::ReportFixture( b2Fixture* fixture )
+{
+	if (fixture->IsSensor())
+	{
+		return true;
+	}
+	oBody* body = (oBody*)fixture->GetBody()->GetUserData();
+	b2Shape* shape = fixture->GetShape();
+	bool isCommonShape = shape->GetType() != b2Shape::e_chain && shape->GetType() != b2Shape::e_edge;
+	/* a single fixture with one child is reported once per rect,
+	 others may report the same body again */
+	bool unique = fixture->GetChildCount() == 1 && fixture->GetBody()->GetFixtureList()->GetNext() == nullptr;
+	for (int i = _first; i < _last; i++)
+	{
+		BLOCK_START
+		{
+			if (isCommonShape)
+			{
+				BREAK_NOT(b2TestOverlap(_aabbs[i], fixture->GetAABB(0)));
+				BREAK_NOT(b2TestOverlap(&_testShapes[i], 0, shape, 0, _transforms[i], fixture->GetBody()->GetTransform()));
+			}
+			else
+			{
+				bool overlap = false;
+				for (int32 child = 0; child < fixture->GetChildCount() && !overlap; child++)
+				{
+					overlap = b2TestOverlap(_aabbs[i], fixture->GetAABB(child));
+				}
+				BREAK_NOT(overlap);
+			}
+			oHit hit = {i, body};
+			if (unique || _reported.insert(hit).second)
+			{
+				hits.push_back(hit);
+			}
+		}
+		BLOCK_END
+	}
+	return true;
+}
+
 float32 oWorld::oRayCast::ReportFixture(b2Fixture* fixture, const b2Vec2& point,
 	const b2Vec2& normal, float32 fraction)
 {
@@ -172,6 +258,7 @@ oVec2 oWorld::getGravity() const
 
 void oWorld::update( float dt )
 {
+	_queryMemo.clear();
 	_world.Step(dt, _velocityIterations, _positionIterations);
 	for (b2Body* b = _world.GetBodyList();b;b = b->GetNext())
 	{
@@ -280,6 +367,115 @@ void oWorld::cast(const oVec2& start, const oVec2& end, bool closest, const func
 	_rayCastCallBack.results.clear();
 }
 
+void oWorld::query(const CCRect rects[], int count, vector<oBody*>& results, vector<int>& offsets)
+{
+	results.clear();
+	offsets.assign(count + 1, 0);
+	if (count <= 0)
+	{
+		return;
+	}
+	_queryBatchCallback.setInfo(rects, count);
+	b2AABB aabb = _queryBatchCallback.getRangeAABB();
+	b2Vec2 extents = aabb.GetExtents();
+	/* rects close to each other share one traversal,
+	 sparse rects are better queried one by one. */
+	if (extents.x * extents.y * 4.0f <= _queryBatchCallback.getRangeArea() * 2.0f)
+	{
+		_world.QueryAABB(&_queryBatchCallback, aabb);
+	}
+	else
+	{
+		for (int i = 0; i < count; i++)
+		{
+			_queryBatchCallback.setRange(i, i + 1);
+			_world.QueryAABB(&_queryBatchCallback, _queryBatchCallback.getRangeAABB());
+		}
+	}
+	vector<oQueryBatch::oHit>& hits = _queryBatchCallback.hits;
+	for (const oQueryBatch::oHit& hit : hits)
+	{
+		offsets[hit.index + 1]++;
+	}
+	for (int i = 0; i < count; i++)
+	{
+		offsets[i + 1] += offsets[i];
+	}
+	results.resize(hits.size());
+	vector<int> cursors(offsets.begin(), offsets.end() - 1);
+	for (const oQueryBatch::oHit& hit : hits)
+	{
+		results[cursors[hit.index]++] = hit.body;
+	}
+	hits.clear();
+}
+
+void oWorld::cast(const oVec2 starts[], const oVec2 ends[], int count, bool closest, vector<oRayCastHit>& results, vector<int>& offsets)
+{
+	results.clear();
+	offsets.resize(count + 1);
+	_rayCastCallBack.closest = closest;
+	for (int i = 0; i < count; i++)
+	{
+		offsets[i] = (int)results.size();
+		_rayCastCallBack.result.body = nullptr;
+		_world.RayCast(&_rayCastCallBack, oWorld::b2Val(starts[i]), oWorld::b2Val(ends[i]));
+		if (closest)
+		{
+			oRayCast::oRayCastData& data = _rayCastCallBack.result;
+			if (data.body)
+			{
+				oRayCastHit hit = {data.body, data.point, data.normal};
+				results.push_back(hit);
+			}
+		}
+		else
+		{
+			for (auto& item : _rayCastCallBack.results)
+			{
+				oRayCastHit hit = {item.body, item.point, item.normal};
+				results.push_back(hit);
+			}
+			_rayCastCallBack.results.clear();
+		}
+	}
+	offsets[count] = (int)results.size();
+}
+
+size_t oWorld::oQueryBatch::oHitHash::operator()(const oHit& hit) const
+{
+	return std::hash<oBody*>()(hit.body) ^ ((size_t)hit.index * 2654435761u);
+}
+
+size_t oWorld::oRectKeyHash::operator()(const oRectKey& key) const
+{
+	float values[] = {key.x, key.y, key.width, key.height};
+	size_t hash = 2166136261u;
+	for (int i = 0; i < 4; i++)
+	{
+		// -0.0f equals 0.0f but has other bits, hash both as 0.0f
+		float value = values[i] == 0.0f ? 0.0f : values[i];
+		uint32 bits;
+		memcpy(&bits, &value, sizeof(bits));
+		hash = (hash ^ bits) * 16777619u;
+	}
+	return hash;
+}
+
+const vector<oBody*>& oWorld::queryCached(const CCRect& rect)
+{
+	oRectKey key = {rect.origin.x, rect.origin.y, rect.size.width, rect.size.height};
+	auto it = _queryMemo.find(key);
+	if (it != _queryMemo.end())
+	{
+		return it->second;
+	}
+	vector<oBody*>& results = _queryMemo[key];
+	vector<int> offsets;
+	oWorld::query(&rect, 1, results, offsets);
+	return results;
+}
+
 void oWorld::setShouldContact( int groupA, int groupB, bool contact )
 {
 	b2Filter& filterA = _filters[groupA];
@@ -294,33 +490,17 @@ void oWorld::setShouldContact( int groupA, int groupB, bool contact )
 		filterA.maskBits &= (~filterB.categoryBits);
 		filterB.maskBits &= (~filterA.categoryBits);
 	}
-	for (b2Body* b = _world.GetBodyList();b;b = b->GetNext())
+	/* contacts are created in refilter order, the group lists keep
+	 the order of fixture attachment so it is the same between runs */
+	for (b2Fixture* f : _groupFixtures[groupA])
 	{
-		b2Fixture* first = b->GetFixtureList();
-		if (first)
+		f->SetFilterData(filterA);
+	}
+	if (groupA != groupB)
+	{
+		for (b2Fixture* f : _groupFixtures[groupB])
 		{
-			int groupIndex = first->GetFilterData().groupIndex;
-			if (groupIndex == groupA)
-			{
-				first->SetFilterData(_filters[groupA]);
-			}
-			else if (groupIndex == groupB)
-			{
-				first->SetFilterData(_filters[groupB]);
-			}
-			// Some shapes make the fixture list a circular list
-			for (b2Fixture* f = first->GetNext();f && f != first;f = f->GetNext())
-			{
-				int groupIndex = f->GetFilterData().groupIndex;
-				if (groupIndex == groupA)
-				{
-					f->SetFilterData(_filters[groupA]);
-				}
-				else if (groupIndex == groupB)
-				{
-					f->SetFilterData(_filters[groupB]);
-				}
-			}
+			f->SetFilterData(filterB);
 		}
 	}
 }
@@ -337,6 +517,42 @@ const b2Filter& oWorld::getFilter( int group ) const
 	return _filters[group];
 }
 
+void oWorld::setFixtureGroup( b2Fixture* fixture, int group )
+{
+	oWorld::removeFixture(fixture);
+	fixture->SetFilterData(_filters[group]);
+	oWorld::addFixture(fixture);
+}
+
+void oWorld::addFixture( b2Fixture* fixture )
+{
+	int group = fixture->GetFilterData().groupIndex;
+	vector<b2Fixture*>& fixtures = _groupFixtures[group];
+	oFixtureSlot slot = {group, (int)fixtures.size()};
+	_fixtureSlots[fixture] = slot;
+	fixtures.push_back(fixture);
+}
+
+void oWorld::removeFixture( b2Fixture* fixture )
+{
+	auto it = _fixtureSlots.find(fixture);
+	if (it != _fixtureSlots.end())
+	{
+		/* move the last fixture into the hole, the order still
+		 only depends on the sequence of adds and removes */
+		vector<b2Fixture*>& fixtures = _groupFixtures[it->second.group];
+		b2Fixture* last = fixtures.back();
+		fixtures[it->second.index] = last;
+		_fixtureSlots[last].index = it->second.index;
+		fixtures.pop_back();
+		_fixtureSlots.erase(it);
+	}
+	if (!_queryMemo.empty())
+	{
+		_queryMemo.clear();
+	}
+}
+
 void oWorld::setContactListener( oOwn<oContactListener>& listener )
 {
 	_contactListner = std::move(listener);
@@ -518,6 +734,12 @@ void oDestructionListener::SayGoodbye(b2Joint* joint)
 	}
 }
 void oDestructionListener::SayGoodbye(b2Fixture* fixture)
-{ }
+{
+	oBody* body = (oBody*)fixture->GetBody()->GetUserData();
+	if (body)
+	{
+		body->getWorld()->removeFixture(fixture);
+	}
+}
 
 NS_DOROTHY_END
@@ -96,9 +96,43 @@ public:
 	 */
 	void query(const CCRect& rect, const function<bool(oBody*)>& callback);
 	void cast(const oVec2& start, const oVec2& end, bool closest, const function<bool(oBody*, const oVec2&, const oVec2&)>& callback);
+	/**
+	 Batched rect query. Rects close to each other are resolved with
+	 one broadphase traversal. Bodies found by rects[i] are stored in
+	 results from index offsets[i] to offsets[i+1], sensors are skipped.
+	 */
+	void query(const CCRect rects[], int count, vector<oBody*>& results, vector<int>& offsets);
+	struct oRayCastHit
+	{
+		oBody* body;
+		oVec2 point;
+		oVec2 normal;
+	};
+	/**
+	 Batched ray cast. Hits of ray i are stored in results
+	 from index offsets[i] to offsets[i+1].
+	 */
+	void cast(const oVec2 starts[], const oVec2 ends[], int count, bool closest, vector<oRayCastHit>& results, vector<int>& offsets);
+	/**
+	 Rect query with results kept until the next world step.
+	 Identical rects queried in the same frame share one traversal.
+	 The memo is dropped whenever a fixture is destroyed, so copy
+	 the result before doing anything that may destroy bodies.
+	 */
+	const vector<oBody*>& queryCached(const CCRect& rect);
+	/**
+	 Only fixtures in groupA and groupB are refiltered, in an order that only
+	 depends on the sequence of fixture attachments and removals.
+	 Other fixtures in the world are not touched.
+	 */
 	void setShouldContact(int groupA, int groupB, bool contact);
 	bool getShouldContact(int groupA, int groupB) const;
 	const b2Filter& getFilter(int group) const;
+	/**
+	 Change a fixture`s filter group and keep it tracked by the world.
+	 Use this instead of b2Fixture::SetFilterData for fixtures of oBody.
+	 */
+	void setFixtureGroup(b2Fixture* fixture, int group);
 	static inline float oVal(float value){ return value * b2Factor; }
 	static inline oVec2 oVal(const b2Vec2& value){ return oVec2(value.x * b2Factor, value.y * b2Factor); }
 	static inline float b2Val(float value){ return value / b2Factor; }
@@ -128,6 +162,49 @@ private:
 		b2PolygonShape testShape;
 		b2Transform transform;
 	} _queryCallback;
+	class oQueryBatch: public b2QueryCallback
+	{
+	public:
+		struct oHit
+		{
+			int index;
+			oBody* body;
+			inline bool operator==(const oHit& other) const
+			{
+				return index == other.index && body == other.body;
+			}
+		};
+		struct oHitHash
+		{
+			size_t operator()(const oHit& hit) const;
+		};
+		void setInfo(const CCRect rects[], int count);
+		void setRange(int first, int last);
+		b2AABB getRangeAABB() const;
+		float getRangeArea() const;
+		vector<oHit> hits;
+		virtual bool ReportFixture( b2Fixture* fixture );
+	private:
+		vector<b2PolygonShape> _testShapes;
+		vector<b2Transform> _transforms;
+		vector<b2AABB> _aabbs;
+		int _first;
+		int _last;
+		unordered_set<oHit, oHitHash> _reported;//Hits of bodies with more than one fixture or child
+	} _queryBatchCallback;
+	struct oRectKey
+	{
+		float x, y, width, height;
+		inline bool operator==(const oRectKey& other) const
+		{
+			return x == other.x && y == other.y && width == other.width && height == other.height;
+		}
+	};
+	struct oRectKeyHash
+	{
+		size_t operator()(const oRectKey& key) const;
+	};
+	unordered_map<oRectKey, vector<oBody*>, oRectKeyHash> _queryMemo;
 	class oRayCast: public b2RayCastCallback
 	{
 	public:
@@ -145,13 +222,24 @@ private:
 protected:
 	oOwn<GLESDebugDraw> _debugDraw;
 private:
+	void addFixture(b2Fixture* fixture);
+	void removeFixture(b2Fixture* fixture);
 	b2Filter _filters[16];
+	struct oFixtureSlot
+	{
+		int group;
+		int index;
+	};
+	vector<b2Fixture*> _groupFixtures[16];
+	unordered_map<b2Fixture*, oFixtureSlot> _fixtureSlots;
 	b2World _world;
 	oOwn<oContactListener> _contactListner;
 	oOwn<oContactFilter> _contactFilter;
 	oOwn<oDestructionListener> _destructionListener;
 	int _velocityIterations;
 	int _positionIterations;
+	friend class oBody;
+	friend class oDestructionListener;
 	CC_LUA_TYPE(oWorld)
 };
 
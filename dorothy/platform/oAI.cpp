@@ -12,191 +12,500 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include "platform/oUnit.h"
 #include "platform/oData.h"
 #include "physics/oSensor.h"
+#include "misc/oAsync.h"
+#include "platform/oPlatformWorld.h"
+#include "platform/oUnitGrid.h"
+#include "platform/oLockstep.h"
+#include <algorithm>
 
 NS_DOROTHY_PLATFORM_BEGIN
 
-oAI::oAI():
-_nearestUnit(nullptr),
-_nearestFriend(nullptr),
-_nearestEnemy(nullptr),
-_nearestNeutral(nullptr),
-_nearestUnitDistance(0),
-_nearestFriendDistance(0),
-_nearestEnemyDistance(0),
-_nearestNeutralDistance(0),
-_oldInstinctValue(0),
-_newInstinctValue(0),
-_friends(CCArray::create()),
-_enemies(CCArray::create()),
-_neutrals(CCArray::create()),
-_detectedUnits(CCArray::create())
-{ }
-
-oAI& oAI::getAI()
+oAIContext::oAIContext()
 {
-	static oAI ai;
-	return ai;
+	oAIContext::reset();
 }
 
-oUnit* oAI::getSelf()
+void oAIContext::reset()
 {
-	return oAI::getAI()._self;
+	_self = nullptr;
+	_nearestUnit = nullptr;
+	_nearestFriend = nullptr;
+	_nearestEnemy = nullptr;
+	_nearestNeutral = nullptr;
+	_nearestUnitDistance = 0;
+	_nearestFriendDistance = 0;
+	_nearestEnemyDistance = 0;
+	_nearestNeutralDistance = 0;
+	_oldInstinctValue = 0;
+	_newInstinctValue = 0;
+	_held = false;
+	_detectedUnits.clear();
+	_friends.clear();
+	_enemies.clear();
+	_neutrals.clear();
+	_detectedArray = nullptr;
+	_friendArray = nullptr;
+	_enemyArray = nullptr;
+	_neutralArray = nullptr;
 }
 
-bool oAI::conditionedReflex(oUnit* unit)
-{	
-	oAILeaf* reflexArc = unit->getReflexArcNode();
-	if (!reflexArc)
+void oAIContext::perceive( oUnit* unit )
+{
+	_self = unit;
+
+	oUnitGrid* grid = oAI::useUnitGrid ? oAI::getUnitGrid(unit) : nullptr;
+	if (grid)
 	{
-		return false;
+		grid->query(unit, unit->getDetectDistance(), oRelation::Any, _detectedUnits);
+	}
+	else
+	{
+		oSensor* seneor = unit->getDetectSensor();
+		if (!seneor)
+		{
+			return;
+		}
+		for (oBody* body : seneor->getSensedBodyList())
+		{
+			oUnit* aroundUnit = CCLuaCast<oUnit>(body->getOwner());
+			if (aroundUnit)
+			{
+				_detectedUnits.push_back(aroundUnit);
+			}
+		}
 	}
-
-	oAI& ai = oAI::getAI();
-
-	ai._self = unit;
-
-	ai._nearestUnit = nullptr;
-	ai._nearestFriend = nullptr;
-	ai._nearestEnemy = nullptr;
-	ai._nearestNeutral = nullptr;
 
 	float minUnitDistance = 0;
 	float minFriendDistance = 0;
 	float minEnemyDistance = 0;
 	float minNeutralDistance = 0;
 
-	oSensor* seneor = unit->getDetectSensor();
-	if (seneor)
+	int count = (int)_detectedUnits.size();
+	_relations.resize(count);
+	if (count > 0)
 	{
-		CCARRAY_START(oBody, body, seneor->getSensedBodies())
-		{
-			oUnit* aroundUnit = CCLuaCast<oUnit>(body->getOwner());
-			if (!aroundUnit) continue;
-
-			ai._detectedUnits->addObject(aroundUnit);
-
-			float newDistance = ccpDistanceSQ(unit->getPosition(), aroundUnit->getPosition());
+		oSharedData.classify(unit, &_detectedUnits[0], count, &_relations[0]);
+	}
+	for (int i = 0; i < count; i++)
+	{
+		oUnit* aroundUnit = _detectedUnits[i];
+		float newDistance = ccpDistanceSQ(unit->getPosition(), aroundUnit->getPosition());
 
-			if (!ai._nearestUnit || newDistance < minUnitDistance)
+		if (!_nearestUnit || newDistance < minUnitDistance)
+		{
+			minUnitDistance = newDistance;
+			_nearestUnit = aroundUnit;
+		}
+		switch (_relations[i])
+		{
+		case oRelation::Friend:
+			_friends.push_back(aroundUnit);
+			if (!_nearestFriend || newDistance < minFriendDistance)
+			{
+				minFriendDistance = newDistance;
+				_nearestFriend = aroundUnit;
+			}
+			break;
+		case oRelation::Enemy:
+			_enemies.push_back(aroundUnit);
+			if (!_nearestEnemy || newDistance < minEnemyDistance)
 			{
-				minUnitDistance = newDistance;
-				ai._nearestUnit = aroundUnit;
+				minEnemyDistance = newDistance;
+				_nearestEnemy = aroundUnit;
 			}
-			oRelation relation = oSharedData.getRelation(ai._self, aroundUnit);
-			switch (relation)
+			break;
+		case oRelation::Neutral:
+			_neutrals.push_back(aroundUnit);
+			if (!_nearestNeutral || newDistance < minNeutralDistance)
 			{
-			case oRelation::Friend:
-				ai._friends->addObject(aroundUnit);
-				if (!ai._nearestFriend || newDistance < minFriendDistance)
-				{
-					minFriendDistance = newDistance;
-					ai._nearestFriend = aroundUnit;
-				}
-				break;
-			case oRelation::Enemy:
-				ai._enemies->addObject(aroundUnit);
-				if (!ai._nearestEnemy || newDistance < minEnemyDistance)
-				{
-					minEnemyDistance = newDistance;
-					ai._nearestEnemy = aroundUnit;
-				}
-				break;
-			case oRelation::Neutral:
-				ai._neutrals->addObject(aroundUnit);
-				if (!ai._nearestNeutral || newDistance < minNeutralDistance)
-				{
-					minNeutralDistance = newDistance;
-					ai._nearestNeutral = aroundUnit;
-				}
-				break;
-			default:
-				break;
+				minNeutralDistance = newDistance;
+				_nearestNeutral = aroundUnit;
 			}
+			break;
+		default:
+			break;
 		}
-		CCARRAY_END
-		ai._nearestUnitDistance = sqrtf(minUnitDistance);
-		ai._nearestFriendDistance = sqrtf(minFriendDistance);
-		ai._nearestEnemyDistance = sqrtf(minEnemyDistance);
-		ai._nearestNeutralDistance = sqrtf(minNeutralDistance);
 	}
-	//Do the Conditioned Reflex
-	bool result = reflexArc->doAction();
+	_nearestUnitDistance = sqrtf(minUnitDistance);
+	_nearestFriendDistance = sqrtf(minFriendDistance);
+	_nearestEnemyDistance = sqrtf(minEnemyDistance);
+	_nearestNeutralDistance = sqrtf(minNeutralDistance);
+}
 
-	ai._friends->removeAllObjects();
-	ai._enemies->removeAllObjects();
-	ai._neutrals->removeAllObjects();
-	ai._detectedUnits->removeAllObjects();
-	ai._self = nullptr;
+void oAIContext::hold()
+{
+	if (_held) return;
+	_held = true;
+	for (oUnit* unit : _detectedUnits)
+	{
+		unit->retain();
+	}
+}
 
-	return result;
+void oAIContext::unhold()
+{
+	if (!_held) return;
+	_held = false;
+	for (oUnit* unit : _detectedUnits)
+	{
+		unit->release();
+	}
 }
 
-CCArray* oAI::getUnitsByRelation( oRelation relation )
+vector<oUnit*>& oAIContext::getUnitList( oRelation relation )
 {
-	oAI& ai = oAI::getAI();
-	CCArray* units = ai._detectedUnits;
 	switch (relation)
 	{
 	case oRelation::Friend:
-		units = ai._friends;
+		return _friends;
+	case oRelation::Enemy:
+		return _enemies;
+	case oRelation::Neutral:
+		return _neutrals;
+	default:
+		return _detectedUnits;
+	}
+}
+
+CCArray* oAIContext::getUnitsByRelation( oRelation relation )
+{
+	oRef<CCArray>* array = &_detectedArray;
+	switch (relation)
+	{
+	case oRelation::Friend:
+		array = &_friendArray;
 		break;
 	case oRelation::Enemy:
-		units = ai._enemies;
+		array = &_enemyArray;
 		break;
 	case oRelation::Neutral:
-		units = ai._neutrals;
+		array = &_neutralArray;
 		break;
 	default:
 		break;
 	}
-	return units;
-}
-
-CCArray* oAI::getDetectedUnits()
-{
-	return oAI::getAI()._detectedUnits;
+	if (!*array)
+	{
+		vector<oUnit*>& units = oAIContext::getUnitList(relation);
+		*array = CCArray::createWithCapacity((unsigned int)units.size());
+		for (oUnit* unit : units)
+		{
+			(*array)->addObject(unit);
+		}
+	}
+	return *array;
 }
 
-oUnit* oAI::getNearestUnit( oRelation relation )
+oUnit* oAIContext::getNearestUnit( oRelation relation ) const
 {
-	oAI& ai = oAI::getAI();
 	switch (relation)
 	{
 	case oRelation::Friend:
-		return ai._nearestFriend;
+		return _nearestFriend;
 	case oRelation::Enemy:
-		return ai._nearestEnemy;
+		return _nearestEnemy;
 	case oRelation::Neutral:
-		return ai._nearestNeutral;
+		return _nearestNeutral;
 	default:
-		return ai._nearestUnit;
+		return _nearestUnit;
 	}
 }
 
-float oAI::getNearestUnitDistance( oRelation relation )
+float oAIContext::getNearestUnitDistance( oRelation relation ) const
 {
-	oAI& ai = oAI::getAI();
 	switch (relation)
 	{
 	case oRelation::Friend:
-		return ai._nearestFriendDistance;
+		return _nearestFriendDistance;
 	case oRelation::Enemy:
-		return ai._nearestEnemyDistance;
+		return _nearestEnemyDistance;
 	case oRelation::Neutral:
-		return ai._nearestNeutralDistance;
+		return _nearestNeutralDistance;
 	default:
-		return ai._nearestUnitDistance;
+		return _nearestUnitDistance;
 	}
 }
 
+/* flushes queued reflex requests after units are updated */
+class oAIFlusher: public CCObject
+{
+public:
+	virtual ~oAIFlusher()
+	{
+		/* unscheduled by the scheduler, as when purging the director */
+		oAI::_flushScheduled = false;
+	}
+	virtual void update(float dt)
+	{
+		oAI::getAI().flushRequests();
+	}
+	static oAIFlusher* create()
+	{
+		oAIFlusher* flusher = new oAIFlusher();
+		flusher->autorelease();
+		return flusher;
+	}
+};
+
+float oAI::thinkInterval = 0.1f;
+bool oAI::useUnitGrid = false;
+float oAI::frameBudget = 3.0f;
+bool oAI::_flushScheduled = false;
+
+oAI::oAI():
+_evaluationCount(0),
+_deferredCount(0),
+_costSampleIndex(0)
+{ }
+
+oAI& oAI::getAI()
+{
+	static oAI ai;
+	return ai;
+}
+
+oAIContext* oAI::acquireContext()
+{
+	if (_freeContexts.empty())
+	{
+		oAIContext* context = new oAIContext();
+		_contextPool.push_back(context);
+		return context;
+	}
+	oAIContext* context = _freeContexts.back();
+	_freeContexts.pop_back();
+	return context;
+}
+
+void oAI::recycleContext( oAIContext* context )
+{
+	context->unhold();
+	context->reset();
+	_freeContexts.push_back(context);
+}
+
+oUnitGrid* oAI::getUnitGrid( oUnit* unit )
+{
+	oPlatformWorld* world = CCLuaCast<oPlatformWorld>(unit->getWorld());
+	return world ? world->getUnitGrid() : nullptr;
+}
+
+oUnit* oAI::getSelf()
+{
+	oAI& ai = oAI::getAI();
+	return ai._contexts.empty() ? nullptr : ai._contexts.back()->_self;
+}
+
+bool oAI::evaluate( oUnit* unit, oAIContext* context )
+{
+	oAILeaf* reflexArc = unit->getReflexArcNode();
+	if (!reflexArc)
+	{
+		return false;
+	}
+	oAI& ai = oAI::getAI();
+	oRef<oUnit> self(unit);
+	context->hold();
+	ai._contexts.push_back(context);
+	//Do the Conditioned Reflex
+	bool result = reflexArc->evaluate();
+	ai._contexts.pop_back();
+	return result;
+}
+
+bool oAI::conditionedReflex(oUnit* unit)
+{
+	if (!unit->getReflexArcNode())
+	{
+		return false;
+	}
+	oAI& ai = oAI::getAI();
+	oAIContext* context = ai.acquireContext();
+	if (useUnitGrid)
+	{
+		oUnitGrid* grid = oAI::getUnitGrid(unit);
+		if (grid) grid->update();
+	}
+	context->perceive(unit);
+	bool result = oAI::evaluate(unit, context);
+	ai.recycleContext(context);
+	return result;
+}
+
+void oAI::requestReflex( oUnit* unit, bool urgent )
+{
+	oAI& ai = oAI::getAI();
+	if (!_flushScheduled)
+	{
+		_flushScheduled = true;
+		/* the scheduler keeps the flusher alive */
+		CCDirector::sharedDirector()->getScheduler()->scheduleUpdateForTarget(oAIFlusher::create(), 1, false);
+	}
+	if (urgent)
+	{
+		if (unit->_reflexRequest == oUnit::UrgentReflex) return;
+		unit->_reflexRequest = oUnit::UrgentReflex;
+		ai._urgentRequests.push_back(unit);
+	}
+	else
+	{
+		if (unit->_reflexRequest != oUnit::NoReflex) return;
+		unit->_reflexRequest = oUnit::NormalReflex;
+		ai._requests.push_back(unit);
+	}
+}
+
+void oAI::flushRequests()
+{
+	_evaluationCount = 0;
+	_deferredCount = 0;
+	if (_requests.empty() && _urgentRequests.empty())
+	{
+		return;
+	}
+	oRefVector<oUnit> requests;
+	requests.swap(_urgentRequests);
+	int urgentCount = (int)requests.size();
+	for (oUnit* unit : _requests)
+	{
+		/* skip the ones escalated to urgent requests */
+		if (unit->_reflexRequest == oUnit::NormalReflex)
+		{
+			requests.push_back(unit);
+		}
+	}
+	_requests.clear();
+	int count = (int)requests.size();
+	vector<oAIContext*> contexts(count);
+	for (int i = 0; i < count; i++)
+	{
+		contexts[i] = oAI::acquireContext();
+		/* grids are rebuilt here, queries in parallel only read them */
+		if (useUnitGrid)
+		{
+			oUnitGrid* grid = oAI::getUnitGrid(requests[i]);
+			if (grid) grid->update();
+		}
+	}
+	oParallel(count, [&](int i)
+	{
+		contexts[i]->perceive(requests[i]);
+	});
+	/* scripts may destroy units, keep all perceived units alive
+	 until every request is evaluated */
+	for (oAIContext* context : contexts)
+	{
+		context->hold();
+	}
+	oRefVector<oUnit> deferred;
+	cc_timeval frameStart;
+	CCTime::gettimeofdayCocos2d(&frameStart, nullptr);
+	for (int i = 0; i < count; i++)
+	{
+		oUnit* unit = requests[i];
+		/* wall clock time differs between runs, lockstep evaluates all */
+		if (i >= urgentCount && frameBudget > 0.0f && oLockstep::getState() == oLockstep::Idle)
+		{
+			cc_timeval now;
+			CCTime::gettimeofdayCocos2d(&now, nullptr);
+			if (CCTime::timersubCocos2d(&frameStart, &now) >= frameBudget)
+			{
+				deferred.push_back(unit);
+				continue;
+			}
+		}
+		unit->_reflexRequest = oUnit::NoReflex;
+		if (unit->getB2Body() && unit->getB2Body()->IsActive())
+		{
+			cc_timeval start, end;
+			CCTime::gettimeofdayCocos2d(&start, nullptr);
+			oAI::evaluate(unit, contexts[i]);
+			CCTime::gettimeofdayCocos2d(&end, nullptr);
+			float cost = (float)CCTime::timersubCocos2d(&start, &end);
+			if ((int)_costSamples.size() < CostSampleCount)
+			{
+				_costSamples.push_back(cost);
+			}
+			else
+			{
+				_costSamples[_costSampleIndex] = cost;
+				_costSampleIndex = (_costSampleIndex + 1) % CostSampleCount;
+			}
+			_evaluationCount++;
+		}
+	}
+	for (oAIContext* context : contexts)
+	{
+		oAI::recycleContext(context);
+	}
+	/* deferred requests go before the ones made during this flush */
+	_deferredCount = (int)deferred.size();
+	if (!deferred.empty())
+	{
+		for (oUnit* unit : _requests)
+		{
+			deferred.push_back(unit);
+		}
+		_requests.swap(deferred);
+	}
+}
+
+int oAI::getEvaluationCount()
+{
+	return oAI::getAI()._evaluationCount;
+}
+
+int oAI::getDeferredCount()
+{
+	return oAI::getAI()._deferredCount;
+}
+
+float oAI::getEvaluationCostP99()
+{
+	vector<float> samples = oAI::getAI()._costSamples;
+	if (samples.empty())
+	{
+		return 0.0f;
+	}
+	size_t index = samples.size() * 99 / 100;
+	std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+	return samples[index];
+}
+
+CCArray* oAI::getUnitsByRelation( oRelation relation )
+{
+	oAI& ai = oAI::getAI();
+	oAIContext* context = ai._contexts.empty() ? &ai._emptyContext : ai._contexts.back();
+	return context->getUnitsByRelation(relation);
+}
+
+CCArray* oAI::getDetectedUnits()
+{
+	return oAI::getUnitsByRelation(oRelation::Unkown);
+}
+
+oUnit* oAI::getNearestUnit( oRelation relation )
+{
+	oAI& ai = oAI::getAI();
+	return ai._contexts.empty() ? nullptr : ai._contexts.back()->getNearestUnit(relation);
+}
+
+float oAI::getNearestUnitDistance( oRelation relation )
+{
+	oAI& ai = oAI::getAI();
+	return ai._contexts.empty() ? 0.0f : ai._contexts.back()->getNearestUnitDistance(relation);
+}
+
 float oAI::getOldInstinctValue()
 {
-	return oAI::getAI()._oldInstinctValue;
+	oAI& ai = oAI::getAI();
+	return ai._contexts.empty() ? 0.0f : ai._contexts.back()->_oldInstinctValue;
 }
 
 float oAI::getNewInstinctValue()
 {
-	return oAI::getAI()._newInstinctValue;
+	oAI& ai = oAI::getAI();
+	return ai._contexts.empty() ? 0.0f : ai._contexts.back()->_newInstinctValue;
 }
 
 void oAI::add( const string& name, oAILeaf* leaf )
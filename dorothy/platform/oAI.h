@@ -13,12 +13,83 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 NS_DOROTHY_PLATFORM_BEGIN
 
 class oUnit;
+class oUnitGrid;
+
+/** @brief Perception and instinct values of one reflex evaluation.
+ Perception only reads sensors, positions and relations,
+ so contexts of different units can be filled in parallel.
+*/
+class oAIContext
+{
+public:
+	oAIContext();
+	void perceive(oUnit* unit);
+	void reset();
+	CCArray* getUnitsByRelation(oRelation relation);
+	oUnit* getNearestUnit(oRelation relation) const;
+	float getNearestUnitDistance(oRelation relation) const;
+private:
+	/* retain perceived units before evaluations run scripts */
+	void hold();
+	void unhold();
+	vector<oUnit*>& getUnitList(oRelation relation);
+	oUnit* _self;
+	oUnit* _nearestUnit;
+	oUnit* _nearestFriend;
+	oUnit* _nearestEnemy;
+	oUnit* _nearestNeutral;
+	float _nearestUnitDistance;
+	float _nearestFriendDistance;
+	float _nearestEnemyDistance;
+	float _nearestNeutralDistance;
+	float _oldInstinctValue;
+	float _newInstinctValue;
+	bool _held;
+	vector<oUnit*> _detectedUnits;
+	vector<oUnit*> _friends;
+	vector<oUnit*> _enemies;
+	vector<oUnit*> _neutrals;
+	vector<oRelation> _relations;
+	/* arrays for scripts, built on request */
+	oRef<CCArray> _detectedArray;
+	oRef<CCArray> _friendArray;
+	oRef<CCArray> _enemyArray;
+	oRef<CCArray> _neutralArray;
+	friend class oAI;
+	friend class oInstinct;
+};
 
 class oAI
 {
 public:
 	enum {None = -1};
+	/** Evaluate the unit`s reflex arc immediately. */
 	static bool conditionedReflex(oUnit* unit);
+	/**
+	 Queue the unit for a reflex evaluation at the end of current frame.
+	 Queued units perceive in parallel and then evaluate one by one.
+	 Normal requests stop being evaluated when the frame budget is used up
+	 and wait for the next frame, urgent requests are always evaluated.
+	 */
+	static void requestReflex(oUnit* unit, bool urgent = false);
+	/**
+	 Perceive units with the unit grid of platform worlds
+	 instead of detect sensors, detect distance is used as the radius.
+	 */
+	static bool useUnitGrid;
+	/** Seconds between reflex evaluations of an idle unit. */
+	static float thinkInterval;
+	/**
+	 Milliseconds per frame for normal reflex evaluations, zero for no limit.
+	 Ignored while oLockstep is running.
+	 */
+	static float frameBudget;
+	/** Number of reflex evaluations in last frame. */
+	static int getEvaluationCount();
+	/** Number of requests deferred to next frame by the budget in last frame. */
+	static int getDeferredCount();
+	/** The 99th percentile cost of recent reflex evaluations in milliseconds. */
+	static float getEvaluationCostP99();
 
 	static oUnit* getSelf();
 	static float getOldInstinctValue();
@@ -34,29 +105,32 @@ public:
 private:
 	oAI();
 	static oAI& getAI();
-
-	oRef<oUnit> _self;
-
-	oUnit* _nearestUnit;
-	oUnit* _nearestFriend;
-	oUnit* _nearestEnemy;
-	oUnit* _nearestNeutral;
-
-	oRef<CCArray> _friends;
-	oRef<CCArray> _enemies;
-	oRef<CCArray> _neutrals;
-	oRef<CCArray> _detectedUnits;
-
-	float _nearestUnitDistance;
-	float _nearestFriendDistance;
-	float _nearestEnemyDistance;
-	float _nearestNeutralDistance;
-
-	float _oldInstinctValue;
-	float _newInstinctValue;
+	static oUnitGrid* getUnitGrid(oUnit* unit);
+	oAIContext* acquireContext();
+	void recycleContext(oAIContext* context);
+	static bool evaluate(oUnit* unit, oAIContext* context);
+	void flushRequests();
+
+	/* contexts of the running evaluations, nested ones are pushed on top */
+	vector<oAIContext*> _contexts;
+	oAIContext _emptyContext;
+	oOwnVector<oAIContext> _contextPool;
+	vector<oAIContext*> _freeContexts;
+
+	oRefVector<oUnit> _requests;
+	oRefVector<oUnit> _urgentRequests;
+	static bool _flushScheduled;
+
+	enum { CostSampleCount = 512 };
+	int _evaluationCount;
+	int _deferredCount;
+	int _costSampleIndex;
+	vector<float> _costSamples;
 
 	unordered_map<string, oRef<oAILeaf>> _reflexArcs;
 	friend class oInstinct;
+	friend class oAIFlusher;
+	friend class oAIContext;
 };
 
 NS_DOROTHY_PLATFORM_END
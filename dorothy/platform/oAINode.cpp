@@ -11,30 +11,34 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include "platform/oAINode.h"
 #include "platform/oAI.h"
 #include "platform/oProperty.h"
+#include "platform/oAction.h"
 #include "platform/oUnit.h"
 #include "misc/oScriptHandler.h"
 
 NS_DOROTHY_PLATFORM_BEGIN
 
 unordered_map<int, oRef<oInstinct>> oInstinct::_instincts;
+unsigned int oAINode::_version = 0;
 
 oInstinct::oInstinct( const string& propName, oAILeaf* node ):
-_actionNode(node),
-_propName(propName)
+_propId(oProperty::getId(propName)),
+_actionNode(node)
 { }
 
 void oInstinct::install(oUnit* unit)
 {
-	oProperty* prop = unit->properties.get(_propName);
+	oProperty* prop = unit->properties.get(_propId);
 	if (prop)
 	{
+		//Reinstalled whenever a property is added, avoid handling twice
+		prop->changed -= std::make_pair(this, &oInstinct::onInstinctPropertyChanged);
 		prop->changed += std::make_pair(this, &oInstinct::onInstinctPropertyChanged);
 	}
 }
 
 void oInstinct::uninstall( oUnit* unit )
 {
-	oProperty* prop = unit->properties.get(_propName);
+	oProperty* prop = unit->properties.get(_propId);
 	if (prop)
 	{
 		prop->changed -= std::make_pair(this, &oInstinct::onInstinctPropertyChanged);
@@ -44,10 +48,15 @@ void oInstinct::uninstall( oUnit* unit )
 void oInstinct::onInstinctPropertyChanged( oUnit* unit, float oldValue, float newValue )
 {
 	oAI& ai = oAI::getAI();
-	ai._self = unit;
-	ai._oldInstinctValue = oldValue;
-	ai._newInstinctValue = newValue;
-	_actionNode->doAction();
+	oRef<oUnit> self(unit);
+	oAIContext* context = ai.acquireContext();
+	context->_self = unit;
+	context->_oldInstinctValue = oldValue;
+	context->_newInstinctValue = newValue;
+	ai._contexts.push_back(context);
+	_actionNode->evaluate();
+	ai._contexts.pop_back();
+	ai.recycleContext(context);
 }
 
 oInstinct* oInstinct::create( const string& propName, oAILeaf* node )
@@ -78,20 +87,207 @@ oInstinct* oInstinct::get( int id )
 	return nullptr;
 }
 
+oAIProgram::oAIProgram():
+_depth(0),
+_maxDepth(0)
+{ }
+
+oAIProgram* oAIProgram::compile( oAILeaf* root )
+{
+	oAIProgram* program = new oAIProgram();
+	root->compile(program);
+	if (program->_maxDepth > MaxDepth)
+	{
+		/* too deep to run with the fixed accumulate stack */
+		delete program;
+		return nullptr;
+	}
+	return program;
+}
+
+int oAIProgram::emit( OpCode op, int arg, float value, oRelation relation )
+{
+	oInstruction instruction = {(uint8)op, (uint8)relation, arg, value};
+	_code.push_back(instruction);
+	return (int)_code.size() - 1;
+}
+
+void oAIProgram::patchJump( int index )
+{
+	_code[index].arg = (int)_code.size();
+}
+
+int oAIProgram::addHandler( oScriptHandler* handler )
+{
+	_handlers.push_back(oRef<oScriptHandler>(handler));
+	return (int)_handlers.size() - 1;
+}
+
+int oAIProgram::addNode( oAILeaf* node )
+{
+	_nodes.push_back(node);
+	return (int)_nodes.size() - 1;
+}
+
+void oAIProgram::beginAccumulate( bool all )
+{
+	oAIProgram::emit(all ? BeginAll : BeginAny);
+	_depth++;
+	_maxDepth = MAX(_maxDepth, _depth);
+}
+
+void oAIProgram::accumulate( bool all )
+{
+	oAIProgram::emit(all ? AccumulateAll : AccumulateAny);
+}
+
+void oAIProgram::endAccumulate()
+{
+	oAIProgram::emit(EndAccumulate);
+	_depth--;
+}
+
+bool oAIProgram::check( OpCode op, oRelation relation, int propId, float value )
+{
+	switch (op)
+	{
+	case DetectUnit:
+		return oAI::getNearestUnit(relation) != nullptr;
+	case NearerThan:
+		return oAI::getNearestUnit(relation) && oAI::getNearestUnitDistance(relation) < value;
+	case FartherThan:
+		return oAI::getNearestUnit(relation) && oAI::getNearestUnitDistance(relation) > value;
+	case PropertyLess:
+	case PropertyGreater:
+	{
+		oUnit* self = oAI::getSelf();
+		oProperty* prop = self ? self->properties.get(propId) : nullptr;
+		float current = prop ? (float)*prop : 0.0f;
+		return op == PropertyLess ? current < value : current > value;
+	}
+	case OnSurface:
+	{
+		oUnit* self = oAI::getSelf();
+		return self && self->isOnSurface();
+	}
+	default:
+		return false;
+	}
+}
+
+bool oAIProgram::run() const
+{
+	bool stack[MaxDepth];
+	int top = 0;
+	bool result = false;
+	int size = (int)_code.size();
+	for (int pc = 0; pc < size;)
+	{
+		const oInstruction& instruction = _code[pc++];
+		switch (instruction.op)
+		{
+		case Load:
+			result = instruction.arg != 0;
+			break;
+		case JumpIfTrue:
+			if (result) pc = instruction.arg;
+			break;
+		case JumpIfFalse:
+			if (!result) pc = instruction.arg;
+			break;
+		case BeginAll:
+			stack[top++] = true;
+			break;
+		case BeginAny:
+			stack[top++] = false;
+			break;
+		case AccumulateAll:
+			stack[top - 1] = stack[top - 1] && result;
+			break;
+		case AccumulateAny:
+			stack[top - 1] = stack[top - 1] || result;
+			break;
+		case EndAccumulate:
+			result = stack[--top];
+			break;
+		case CallScript:
+			result = CCScriptEngine::sharedEngine()->executeFunction(_handlers[instruction.arg]->get()) != 0;
+			break;
+		case StartAction:
+		{
+			oUnit* self = oAI::getSelf();
+			result = self && self->start(instruction.arg);
+			break;
+		}
+		case CallNode:
+			result = _nodes[instruction.arg]->doAction();
+			break;
+		case PropertyLess:
+		case PropertyGreater:
+			result = oAIProgram::check((OpCode)instruction.op, oRelation::Unkown, instruction.arg, instruction.value);
+			break;
+		default:
+			result = oAIProgram::check((OpCode)instruction.op, (oRelation)instruction.relation, 0, instruction.value);
+			break;
+		}
+	}
+	return result;
+}
+
+oAILeaf::oAILeaf():
+_compiled(false),
+_programVersion(0),
+_running(0)
+{ }
+
+void oAILeaf::compile( oAIProgram* program )
+{
+	program->emit(oAIProgram::CallNode, program->addNode(this));
+}
+
+bool oAILeaf::evaluate()
+{
+	/* a running program is not replaced even if scripts change the tree,
+	 nested evaluations keep using it until it returns */
+	if (_running == 0 && (!_compiled || _programVersion != oAINode::getVersion()))
+	{
+		_program = oOwnMake(oAIProgram::compile(this));
+		_programVersion = oAINode::getVersion();
+		_compiled = true;
+	}
+	if (!_program)
+	{
+		return this->doAction();
+	}
+	oRef<oAILeaf> self(this);
+	_running++;
+	bool result = _program->run();
+	_running--;
+	return result;
+}
+
 oAINode* oAINode::add( oAILeaf* node )
 {
 	_children.push_back(node);
+	_version++;
 	return this;
 }
 
 void oAINode::remove( oAILeaf* node )
 {
 	_children.remove(node);
+	_version++;
 }
 
 void oAINode::clear()
 {
 	_children.clear();
+	_version++;
+}
+
+unsigned int oAINode::getVersion()
+{
+	return _version;
 }
 
 const oRefVector<oAILeaf>& oAINode::getChildren() const
@@ -111,6 +307,28 @@ bool oSelNode::doAction()
 	return false;
 }
 
+void oSelNode::compile( oAIProgram* program )
+{
+	if (_children.empty())
+	{
+		program->emit(oAIProgram::Load, 0);
+		return;
+	}
+	vector<int> jumps;
+	for (size_t i = 0; i < _children.size(); i++)
+	{
+		_children[i]->compile(program);
+		if (i + 1 < _children.size())
+		{
+			jumps.push_back(program->emit(oAIProgram::JumpIfTrue));
+		}
+	}
+	for (int jump : jumps)
+	{
+		program->patchJump(jump);
+	}
+}
+
 oSelNode* oSelNode::create()
 {
 	oSelNode* node = new oSelNode();
@@ -127,6 +345,28 @@ oSeqNode* oSeqNode::create()
 	return node;
 }
 
+void oSeqNode::compile( oAIProgram* program )
+{
+	if (_children.empty())
+	{
+		program->emit(oAIProgram::Load, 1);
+		return;
+	}
+	vector<int> jumps;
+	for (size_t i = 0; i < _children.size(); i++)
+	{
+		_children[i]->compile(program);
+		if (i + 1 < _children.size())
+		{
+			jumps.push_back(program->emit(oAIProgram::JumpIfFalse));
+		}
+	}
+	for (int jump : jumps)
+	{
+		program->patchJump(jump);
+	}
+}
+
 bool oSeqNode::doAction()
 {
 	for (oAILeaf* node : _children)
@@ -147,6 +387,17 @@ oParSelNode* oParSelNode::create()
 	return node;
 }
 
+void oParSelNode::compile( oAIProgram* program )
+{
+	program->beginAccumulate(true);
+	for (oAILeaf* node : _children)
+	{
+		node->compile(program);
+		program->accumulate(true);
+	}
+	program->endAccumulate();
+}
+
 bool oParSelNode::doAction()
 {
 	bool result = true;
@@ -168,6 +419,17 @@ oParSeqNode* oParSeqNode::create()
 	return node;
 }
 
+void oParSeqNode::compile( oAIProgram* program )
+{
+	program->beginAccumulate(false);
+	for (oAILeaf* node : _children)
+	{
+		node->compile(program);
+		program->accumulate(false);
+	}
+	program->endAccumulate();
+}
+
 bool oParSeqNode::doAction()
 {
 	bool result = false;
@@ -186,6 +448,11 @@ bool oConNode::doAction()
 	return CCScriptEngine::sharedEngine()->executeFunction(_handler->get()) != 0;
 }
 
+void oConNode::compile( oAIProgram* program )
+{
+	program->emit(oAIProgram::CallScript, program->addHandler(_handler));
+}
+
 oConNode* oConNode::create( int handler )
 {
 	oConNode* node = new oConNode();
@@ -195,16 +462,52 @@ oConNode* oConNode::create( int handler )
 	return node;
 }
 
+bool oNativeConNode::doAction()
+{
+	return oAIProgram::check(_op, _relation, _propId, _value);
+}
+
+void oNativeConNode::compile( oAIProgram* program )
+{
+	switch (_op)
+	{
+	case oAIProgram::PropertyLess:
+	case oAIProgram::PropertyGreater:
+		program->emit(_op, _propId, _value);
+		break;
+	default:
+		program->emit(_op, 0, _value, _relation);
+		break;
+	}
+}
+
+oNativeConNode* oNativeConNode::create( oAIProgram::OpCode op, oRelation relation, const string& name, float value )
+{
+	oNativeConNode* node = new oNativeConNode();
+	CC_INIT(node);
+	node->_op = op;
+	node->_relation = relation;
+	node->_propId = name.empty() ? -1 : oProperty::getId(name);
+	node->_value = value;
+	node->autorelease();
+	return node;
+}
+
 bool oActNode::doAction()
 {
-	return oAI::getSelf()->start(_actionName);
+	return oAI::getSelf()->start(_actionId);
+}
+
+void oActNode::compile( oAIProgram* program )
+{
+	program->emit(oAIProgram::StartAction, _actionId);
 }
 
 oActNode* oActNode::create(const string& actionName)
 {
 	oActNode* node = new oActNode();
 	CC_INIT(node);
-	node->_actionName = actionName;
+	node->_actionId = oAction::getId(actionName);
 	node->autorelease();
 	return node;
 }
@@ -253,5 +556,29 @@ oAILeaf* oAct(const string& actionName)
 {
 	return oActNode::create(actionName);
 }
+oAILeaf* oConDetect(oRelation relation)
+{
+	return oNativeConNode::create(oAIProgram::DetectUnit, relation, string(), 0.0f);
+}
+oAILeaf* oConNearer(oRelation relation, float distance)
+{
+	return oNativeConNode::create(oAIProgram::NearerThan, relation, string(), distance);
+}
+oAILeaf* oConFarther(oRelation relation, float distance)
+{
+	return oNativeConNode::create(oAIProgram::FartherThan, relation, string(), distance);
+}
+oAILeaf* oConLess(const string& propName, float value)
+{
+	return oNativeConNode::create(oAIProgram::PropertyLess, oRelation::Unkown, propName, value);
+}
+oAILeaf* oConGreater(const string& propName, float value)
+{
+	return oNativeConNode::create(oAIProgram::PropertyGreater, oRelation::Unkown, propName, value);
+}
+oAILeaf* oConOnSurface()
+{
+	return oNativeConNode::create(oAIProgram::OnSurface, oRelation::Unkown, string(), 0.0f);
+}
 
 NS_DOROTHY_PLATFORM_END
@@ -33,16 +33,85 @@ public:
 protected:
 	oInstinct(const string& propName, oAILeaf* node);
 private:
-	string _propName;
+	int _propId;
 	oRef<oAILeaf> _actionNode;
 	static unordered_map<int, oRef<oInstinct>> _instincts;
 };
 
+/** @brief Behavior tree flattened into an instruction array.
+ Selector and sequence nodes become conditional jumps, parallel nodes
+ accumulate the results of all their children on a small stack.
+ Native conditions run as opcodes without calling scripts.
+*/
+class oAIProgram
+{
+public:
+	enum OpCode
+	{
+		Load,
+		JumpIfTrue,
+		JumpIfFalse,
+		BeginAll,
+		BeginAny,
+		AccumulateAll,
+		AccumulateAny,
+		EndAccumulate,
+		CallScript,
+		StartAction,
+		CallNode,
+		/* native conditions */
+		DetectUnit,
+		NearerThan,
+		FartherThan,
+		PropertyLess,
+		PropertyGreater,
+		OnSurface
+	};
+	struct oInstruction
+	{
+		uint8 op;
+		uint8 relation;
+		int arg;
+		float value;
+	};
+	/** Return nullptr when the tree is too deep to be compiled. */
+	static oAIProgram* compile(oAILeaf* root);
+	bool run() const;
+	int emit(OpCode op, int arg = 0, float value = 0.0f, oRelation relation = oRelation::Unkown);
+	/** Make the jump instruction at the index jump to the end of program. */
+	void patchJump(int index);
+	int addHandler(oScriptHandler* handler);
+	int addNode(oAILeaf* node);
+	void beginAccumulate(bool all);
+	void accumulate(bool all);
+	void endAccumulate();
+	static bool check(OpCode op, oRelation relation, int propId, float value);
+private:
+	oAIProgram();
+	enum { MaxDepth = 64 };
+	vector<oInstruction> _code;
+	vector<oRef<oScriptHandler>> _handlers;
+	oRefVector<oAILeaf> _nodes;
+	int _depth;
+	int _maxDepth;
+};
+
 /** @brief Behavior Tree base node */
 class oAILeaf: public CCObject
 {
 public:
 	virtual bool doAction() = 0;
+	/** Emit instructions for this node, calls doAction() by default. */
+	virtual void compile(oAIProgram* program);
+	/** Run the node as the root of a tree with its compiled program. */
+	bool evaluate();
+protected:
+	oAILeaf();
+private:
+	oOwn<oAIProgram> _program;
+	bool _compiled;
+	unsigned int _programVersion;
+	int _running;
 	CC_LUA_TYPE(oAILeaf)
 };
 
@@ -53,8 +122,11 @@ public:
 	void remove(oAILeaf* node);
 	void clear();
 	const oRefVector<oAILeaf>& getChildren() const;
+	/** Increased on every change of any tree to invalidate compiled programs. */
+	static unsigned int getVersion();
 protected:
 	oRefVector<oAILeaf> _children;
+	static unsigned int _version;
 };
 
 /** @brief Selector Node */
@@ -62,6 +134,7 @@ class oSelNode: public oAINode
 {
 public:
 	virtual bool doAction();
+	virtual void compile(oAIProgram* program);
 	static oSelNode* create();
 };
 
@@ -70,6 +143,7 @@ class oSeqNode: public oAINode
 {
 public:
 	virtual bool doAction();
+	virtual void compile(oAIProgram* program);
 	static oSeqNode* create();
 };
 
@@ -78,6 +152,7 @@ class oParSelNode: public oAINode
 {
 public:
 	virtual bool doAction();
+	virtual void compile(oAIProgram* program);
 	static oParSelNode* create();
 };
 
@@ -86,6 +161,7 @@ class oParSeqNode: public oAINode
 {
 public:
 	virtual bool doAction();
+	virtual void compile(oAIProgram* program);
 	static oParSeqNode* create();
 };
 
@@ -93,18 +169,34 @@ class oConNode: public oAILeaf
 {
 public:
 	virtual bool doAction();
+	virtual void compile(oAIProgram* program);
 	static oConNode* create(int handler);
 private:
 	oRef<oScriptHandler> _handler;
 };
 
+/** @brief Condition node checked in native code without calling scripts. */
+class oNativeConNode: public oAILeaf
+{
+public:
+	virtual bool doAction();
+	virtual void compile(oAIProgram* program);
+	static oNativeConNode* create(oAIProgram::OpCode op, oRelation relation, const string& name, float value);
+private:
+	oAIProgram::OpCode _op;
+	oRelation _relation;
+	int _propId;
+	float _value;
+};
+
 class oActNode: public oAILeaf
 {
 public:
 	virtual bool doAction();
+	virtual void compile(oAIProgram* program);
 	static oActNode* create(const string& actionName);
 private:
-	string _actionName;
+	int _actionId;
 };
 
 oAILeaf* oSel(oAILeaf* nodes[], int count);
@@ -113,6 +205,13 @@ oAILeaf* oParSel(oAILeaf* nodes[], int count);
 oAILeaf* oParSeq(oAILeaf* nodes[], int count);
 oAILeaf* oCon(int handler);
 oAILeaf* oAct(const string& actionName);
+/* native conditions */
+oAILeaf* oConDetect(oRelation relation);
+oAILeaf* oConNearer(oRelation relation, float distance);
+oAILeaf* oConFarther(oRelation relation, float distance);
+oAILeaf* oConLess(const string& propName, float value);
+oAILeaf* oConGreater(const string& propName, float value);
+oAILeaf* oConOnSurface();
 
 NS_DOROTHY_PLATFORM_END
 
@@ -14,6 +14,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include "platform/oBulletDef.h"
 #include "platform/oBullet.h"
 #include "platform/oAI.h"
+#include "platform/oUnitBatch.h"
 #include "model/oModelDef.h"
 #include "model/oModel.h"
 #include "physics/oSensor.h"
@@ -21,6 +22,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include "effect/oEffectCache.h"
 #include "misc/oScriptHandler.h"
 #include "misc/oHelper.h"
+#include "misc/oIdTable.h"
 #include "audio/oAudio.h"
 
 NS_DOROTHY_PLATFORM_BEGIN
@@ -37,9 +39,10 @@ oAction* oActionDef::toAction(oUnit* unit)
 }
 
 // oAction
-unordered_map<string, oOwn<oActionDef>> oAction::_actionDefs;
+vector<oOwn<oActionDef>> oAction::_actionDefs;
 
 oAction::oAction(const string& name, int priority, oUnit* owner):
+_id(oAction::getId(name)),
 _name(name),
 _priority(priority),
 _isDoing(false),
@@ -49,6 +52,8 @@ reaction(-1.0f)
 
 oAction::~oAction()
 {
+	//Scripts get actions by address, drop the box before the address is reused
+	CCScriptEngine::sharedEngine()->removeUserType(this);
 	_owner = nullptr;
 }
 
@@ -57,6 +62,11 @@ const string& oAction::getName() const
 	return _name;
 }
 
+int oAction::getId() const
+{
+	return _id;
+}
+
 int oAction::getPriority() const
 {
 	return _priority;
@@ -81,6 +91,7 @@ void oAction::run()
 {
 	_isDoing = true;
 	_reflexDelta = 0.0f;
+	oUnitBatch::startAction(_owner, _owner->sensity * oAction::reaction);
 	if (actionStart)
 	{
 		actionStart(this);
@@ -89,6 +100,8 @@ void oAction::run()
 
 void oAction::update( float dt )
 {
+	//The batch of a batched owner runs the reaction timer
+	if (oUnitBatch::isBatched(_owner)) return;
 	float reactionTime = _owner->sensity * oAction::reaction;
 	if (reactionTime >= 0)
 	{
@@ -97,7 +110,7 @@ void oAction::update( float dt )
 		{
 			_reflexDelta = 0.0f;
 			//Check AI here
-			oAI::conditionedReflex(_owner);
+			oAI::requestReflex(_owner);
 		}
 	}
 }
@@ -105,6 +118,7 @@ void oAction::update( float dt )
 void oAction::stop()
 {
 	_isDoing = false;
+	oUnitBatch::stopAction(_owner);
 	if (actionEnd)
 	{
 		actionEnd(this);
@@ -121,7 +135,12 @@ void oAction::add( const string& name, int priority, float reaction, float recov
 	actionDef->available = oScriptHandler::create(available);
 	actionDef->create = oScriptHandler::create(create);
 	actionDef->stop = oScriptHandler::create(stop);
-	_actionDefs[name] = oOwnMake(actionDef);
+	int id = oAction::getId(name);
+	if ((int)_actionDefs.size() <= id)
+	{
+		_actionDefs.resize(id + 1);
+	}
+	_actionDefs[id] = oOwnMake(actionDef);
 }
 
 void oAction::clear()
@@ -188,6 +207,8 @@ void oWalk::run()
 	model->setRecovery(oAction::recovery);
 	model->resume(oID::AnimationWalk);
 	_eclapsed = 0.0f;
+	//A batched owner walks from the arrays of its batch
+	oUnitBatch::startWalk(_owner, oAction::recovery);
 	oAction::run();
 }
 
@@ -319,7 +340,7 @@ void oJump::run()
 	_owner->setVelocityY(_owner->jump);
 	oSensor* sensor = _owner->getGroundSensor();
 	b2Body* self = _owner->getB2Body();
-	b2Body* target = ((oBody*)sensor->getSensedBodies()->objectAtIndex(0))->getB2Body();
+	b2Body* target = sensor->getSensedBodyList().front()->getB2Body();
 	b2DistanceInput input =
 	{
 		b2DistanceProxy(self->GetFixtureList()->GetShape(), 0),
@@ -504,7 +525,9 @@ void oMeleeAttack::onAttack()
 	oSensor* sensor = _owner->getAttackSensor();
 	if (sensor)
 	{
-		CCARRAY_START(oBody, body, sensor->getSensedBodies())
+		/* damage callbacks may change the sensor, iterate on a retained copy */
+		oRef<CCArray> bodies(sensor->getSensedBodies());
+		CCARRAY_START(oBody, body, bodies)
 		{
 			oUnit* target = CCLuaCast<oUnit>(body->getOwner());
 			BLOCK_START
@@ -516,7 +539,7 @@ void oMeleeAttack::onAttack()
 				oRelation relation = oSharedData.getRelation(_owner, target);
 				BREAK_IF(!_owner->targetAllow.isAllow(relation));
 				/* Get hit point */
-				oHit* hitAction = (oHit*)(target->getAction(oID::ActionHit));
+				oHit* hitAction = (oHit*)(target->getAction(oID::ActionHitId));
 				if (hitAction)
 				{
 					oVec2 hitPoint = oUnitDef::usePreciseHit ? oAttack::getHitPoint(_owner, target, &_polygon) : oVec2(target->getPosition());
@@ -524,7 +547,7 @@ void oMeleeAttack::onAttack()
 				}
 				/* Make damage */
 				float damage = oAttack::getDamage(target);
-				target->properties["hp"] -= damage;
+				target->properties[oProperty::HP] -= damage;
 				if (damaged)
 				{
 					damaged(_owner, target, damage);
@@ -567,7 +590,7 @@ void oRangeAttack::onAttack()
 bool oRangeAttack::onHitTarget( oBullet* bullet, oUnit* target )
 {
 	/* Get hit point */
-	oHit* hitAction = (oHit*)(target->getAction(oID::ActionHit));
+	oHit* hitAction = (oHit*)(target->getAction(oID::ActionHitId));
 	if (hitAction)
 	{
 		b2Shape* shape = bullet->getDetectSensor()->getFixture()->GetShape();
@@ -577,7 +600,7 @@ bool oRangeAttack::onHitTarget( oBullet* bullet, oUnit* target )
 	}
 	/* Make damage */
 	float damage = oAttack::getDamage(target);
-	target->properties["hp"] -= damage;
+	target->properties[oProperty::HP] -= damage;
 	if (damaged)
 	{
 		damaged(_owner, target, damage);
@@ -735,33 +758,74 @@ const char* oID::ActionHit = "hit";
 const char* oID::ActionDie = "die";
 
 typedef oAction* (*oActionFunc)(oUnit* unit);
-static const unordered_map<string,oActionFunc> g_createFuncs =
-{
-	{oID::ActionWalk, &oWalk::create},
-	{oID::ActionTurn, &oTurn::create},
-	{oID::ActionMeleeAttack, &oMeleeAttack::create},
-	{oID::ActionRangeAttack, &oRangeAttack::create},
-	{oID::ActionIdle, &oIdle::create},
-	{oID::ActionCancel, &oCancel::create},
-	{oID::ActionJump, &oJump::create},
-	{oID::ActionHit, &oHit::create},
-	{oID::ActionDie, &oDie::create}
+//Indexed by the built-in action ids
+static const oActionFunc g_createFuncs[] =
+{
+	&oWalk::create,
+	&oTurn::create,
+	&oMeleeAttack::create,
+	&oRangeAttack::create,
+	&oIdle::create,
+	&oCancel::create,
+	&oJump::create,
+	&oHit::create,
+	&oDie::create
 };
 
+static oIdTable& oGetActionNames()
+{
+	static oIdTable names;
+	if (names.getCount() == 0)
+	{
+		const char* builtins[] =
+		{
+			oID::ActionWalk,
+			oID::ActionTurn,
+			oID::ActionMeleeAttack,
+			oID::ActionRangeAttack,
+			oID::ActionIdle,
+			oID::ActionCancel,
+			oID::ActionJump,
+			oID::ActionHit,
+			oID::ActionDie
+		};
+		for (const char* name : builtins)
+		{
+			names.getId(string(name));
+		}
+	}
+	return names;
+}
+
+int oAction::getId( const string& name )
+{
+	return oGetActionNames().getId(name);
+}
+
+int oAction::getId( const char* name )
+{
+	return oGetActionNames().getId(name);
+}
+
+const string& oAction::getName( int id )
+{
+	return oGetActionNames().getName(id);
+}
+
 oAction* oAction::create( const string& name, oUnit* unit )
 {
-	auto it = _actionDefs.find(name);
-	if (it != _actionDefs.end())
+	return oAction::create(oAction::getId(name), unit);
+}
+
+oAction* oAction::create( int id, oUnit* unit )
+{
+	if (0 <= id && id < (int)_actionDefs.size() && _actionDefs[id])
 	{
-		return it->second->toAction(unit);
+		return _actionDefs[id]->toAction(unit);
 	}
-	else
+	else if (0 <= id && id < oID::BuiltinActionCount)
 	{
-		auto it = g_createFuncs.find(name);
-		if (it != g_createFuncs.end())
-		{
-			return it->second(unit);
-		}
+		return g_createFuncs[id](unit);
 	}
 	return nullptr;
 }
@@ -47,6 +47,7 @@ public:
 	int getPriority() const;
 	bool isDoing() const;
 	oUnit* getOwner() const;
+	int getId() const;
 	oActionHandler actionStart;
 	oActionHandler actionEnd;
 	virtual bool isAvailable();
@@ -54,6 +55,11 @@ public:
 	virtual void update(float dt);
 	virtual void stop();
 	static oAction* create(const string& name, oUnit* unit);
+	static oAction* create(int id, oUnit* unit);
+	/** Action names are interned to compact ids shared by all units. */
+	static int getId(const string& name);
+	static int getId(const char* name);
+	static const string& getName(int id);
 	static void add(
 		const string& name,
 		int priority,
@@ -67,10 +73,11 @@ protected:
 	oUnit* _owner;
 private:
 	bool _isDoing;
+	int _id;
 	string _name;
 	int _priority;
 	float _reflexDelta;
-	static unordered_map<string, oOwn<oActionDef>> _actionDefs;
+	static vector<oOwn<oActionDef>> _actionDefs;
 };
 
 class oScriptAction: public oAction
@@ -107,6 +114,20 @@ struct oID
 	static const char* ActionJump;
 	static const char* ActionHit;
 	static const char* ActionDie;
+	/** Ids of the built-in actions, which are interned first. */
+	enum
+	{
+		ActionWalkId,
+		ActionTurnId,
+		ActionMeleeAttackId,
+		ActionRangeAttackId,
+		ActionIdleId,
+		ActionCancelId,
+		ActionJumpId,
+		ActionHitId,
+		ActionDieId,
+		BuiltinActionCount
+	};
 
 	static const int PriorityWalk;
 	static const int PriorityTurn;
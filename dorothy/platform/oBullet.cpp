@@ -30,12 +30,29 @@ _lifeTime(bulletDef->lifeTime),
 _face(nullptr)
 { }
 
+oBullet::~oBullet()
+{
+	if (_bulletDef)
+	{
+		_bulletDef->_activeCount--;
+	}
+}
+
 bool oBullet::init()
 {
 	if (!oBody::init()) return false;
+	oBullet::arm();
+	return true;
+}
+
+void oBullet::arm()
+{
+	_current = 0;
+	_lifeTime = _bulletDef->lifeTime;
 	oBullet::setFaceRight(_owner->isFaceRight());
 	oBullet::setTag(_bulletDef->tag);
 	_detectSensor = oBody::getSensorByTag(oBulletDef::SensorTag);
+	_detectSensor->setEnabled(true);
 	_detectSensor->bodyEnter += std::make_pair(this, &oBullet::onBodyEnter);
 	oVec2 v = _bulletDef->getVelocity();
 	oBody::setVelocity((_isFaceRight ? v.x : -v.x), v.y);
@@ -57,7 +74,35 @@ bool oBullet::init()
 		oBullet::setRotation(-CC_RADIANS_TO_DEGREES(atan2f(v.y, _owner->isFaceRight() ? v.x : -v.x)));
 	}
 	this->scheduleUpdate();
-	return true;
+}
+
+/* Keep the bullet with its Box2D body in the pool of bullet def
+ when there is room, otherwise destroy it as usual. */
+void oBullet::recycle()
+{
+	if (!_bodyB2 || !_bulletDef->recycleBullet(this))
+	{
+		oBody::destroy();
+		return;
+	}
+	oRef<oBullet> self(this);
+	CCNode::stopAllActions();
+	CCNode::unscheduleAllSelectors();
+	CCNode::setUserObject(nullptr);
+	CCNode::setHelperObject(nullptr);
+	if (m_pParent)
+	{
+		m_pParent->removeChild(this, false);
+	}
+	oSensor* sensor = oBody::getSensorByTag(oBulletDef::SensorTag);
+	sensor->bodyEnter.Clear();
+	sensor->bodyLeave.Clear();
+	contactStart.Clear();
+	contactEnd.Clear();
+	_bodyB2->SetAngularVelocity(0.0f);
+	targetAllow = oTargetAllow();
+	_owner = nullptr;
+	_bulletDef = nullptr;
 }
 
 void oBullet::updatePhysics()
@@ -108,9 +153,19 @@ void oBullet::cleanup()
 
 oBullet* oBullet::create(oBulletDef* def, oUnit* unit)
 {
-	oBullet* bullet = new oBullet(def, unit);
+	oBullet* bullet = def->reuseBullet(unit->getWorld());
+	if (bullet)
+	{
+		bullet->_bulletDef = def;
+		bullet->_owner = unit;
+		bullet->arm();
+		def->onBulletArmed(true);
+		return bullet;
+	}
+	bullet = new oBullet(def, unit);
 	CC_INIT(bullet);
 	bullet->autorelease();
+	def->onBulletArmed(false);
 	return bullet;
 }
 
@@ -155,15 +210,22 @@ void oBullet::onBodyEnter( oSensor* sensor, oBody* body )
 				pos.y - _bulletDef->damageRadius,
 				_bulletDef->damageRadius * 2,
 				_bulletDef->damageRadius * 2);
-			_world->query(rect, [&](oBody* body)
+			vector<oBody*> bodies;
+			vector<int> offsets;
+			_world->query(&rect, 1, bodies, offsets);
+			oRefVector<oUnit> targets;
+			for (oBody* body : bodies)
 			{
 				oUnit* unit = CCLuaCast<oUnit>(body->getOwner());
 				if (unit && targetAllow.isAllow(oSharedData.getRelation(_owner, unit)))
 				{
-					hitTarget(this, unit);
+					targets.push_back(unit);
 				}
-				return false;
-			});
+			}
+			for (oUnit* unit : targets)
+			{
+				hitTarget(this, unit);
+			}
 		}
 		else if (isHitUnit)
 		{
@@ -209,7 +271,7 @@ void oBullet::onFaceDisposed( oIDisposable* item )
 {
 	_face = nullptr;
 	item->disposing.Clear();
-	oBody::destroy();
+	oBullet::recycle();
 }
 
 void oBullet::destroy()
@@ -235,7 +297,7 @@ void oBullet::destroy()
 	}
 	else
 	{
-		oBody::destroy();
+		oBullet::recycle();
 	}
 }
 
@@ -42,9 +42,12 @@ public:
 	oTargetAllow targetAllow;
 	oBulletHandler hitTarget;
 	virtual void destroy();
+	virtual ~oBullet();
 protected:
 	oBullet(oBulletDef* def, oUnit* unit);
 	virtual void updatePhysics();
+	void arm();
+	void recycle();
 private:
 	oRef<oBulletDef> _bulletDef;
 	oRef<oUnit> _owner;
@@ -18,6 +18,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include "model/oModel.h"
 #include "model/oFace.h"
 #include "effect/oEffectCache.h"
+#include "physics/oWorld.h"
 
 NS_DOROTHY_PLATFORM_BEGIN
 
@@ -28,9 +29,19 @@ tag(0),
 lifeTime(0),
 damageRadius(0),
 endEffect(),
+poolCapacity(0),
+_activeCount(0),
+_peakCount(0),
+_createdCount(0),
+_reusedCount(0),
 _bodyDef(oBodyDef::create())
 { }
 
+oBulletDef::~oBulletDef()
+{
+	oBulletDef::clearPool();
+}
+
 oBodyDef* oBulletDef::getBodyDef() const
 {
 	return _bodyDef;
@@ -83,6 +94,7 @@ float oBulletDef::getGravityScale() const
 
 void oBulletDef::setAsCircle( float radius )
 {
+	oBulletDef::clearPool();
 	_bodyDef->clearFixtures();
 	_bodyDef->attachCircleSensor(oBulletDef::SensorTag, radius);
 }
@@ -97,4 +109,70 @@ oFace* oBulletDef::getFace() const
 	return _face;
 }
 
+oBullet* oBulletDef::reuseBullet(oWorld* world)
+{
+	while (!_pool.empty())
+	{
+		oRef<oBullet> bullet = _pool.back();
+		_pool.pop_back();
+		/* bullets cleaned up by their world can`t be reused */
+		if (bullet->getB2Body() && bullet->getWorld() == world)
+		{
+			bullet->retain();
+			bullet->autorelease();
+			return bullet;
+		}
+	}
+	return nullptr;
+}
+
+bool oBulletDef::recycleBullet(oBullet* bullet)
+{
+	if ((int)_pool.size() < poolCapacity)
+	{
+		_pool.push_back(bullet);
+		_activeCount--;
+		return true;
+	}
+	return false;
+}
+
+void oBulletDef::onBulletArmed(bool reused)
+{
+	if (reused) _reusedCount++;
+	else _createdCount++;
+	_activeCount++;
+	_peakCount = MAX(_peakCount, _activeCount);
+}
+
+void oBulletDef::clearPool()
+{
+	_pool.clear();
+}
+
+int oBulletDef::getPoolIdleCount() const
+{
+	return (int)_pool.size();
+}
+
+int oBulletDef::getPoolActiveCount() const
+{
+	return _activeCount;
+}
+
+int oBulletDef::getPoolPeakCount() const
+{
+	return _peakCount;
+}
+
+int oBulletDef::getPoolCreatedCount() const
+{
+	return _createdCount;
+}
+
+int oBulletDef::getPoolReusedCount() const
+{
+	return _reusedCount;
+}
+
 NS_DOROTHY_PLATFORM_END
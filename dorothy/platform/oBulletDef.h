@@ -33,6 +33,19 @@ public:
 	float lifeTime;
 	float damageRadius;
 	string endEffect;
+	/**
+	 Max count of destroyed bullets kept for reuse, 0 to disable pooling.
+	 Pooled bullets are deactivated when destroyed and re-armed
+	 when created again instead of rebuilding the Box2D body.
+	 */
+	int poolCapacity;
+	PROPERTY_READONLY(int, PoolIdleCount);
+	PROPERTY_READONLY(int, PoolActiveCount);
+	PROPERTY_READONLY(int, PoolPeakCount);
+	PROPERTY_READONLY(int, PoolCreatedCount);
+	PROPERTY_READONLY(int, PoolReusedCount);
+	void clearPool();
+	virtual ~oBulletDef();
 	static oBulletDef* create();
 	void setAsCircle(float radius);
 	oBodyDef* getBodyDef() const;
@@ -41,6 +54,16 @@ protected:
 	oBulletDef();
 	oRef<oBodyDef> _bodyDef;
 	oRef<oFace> _face;
+private:
+	oBullet* reuseBullet(oWorld* world);
+	bool recycleBullet(oBullet* bullet);
+	void onBulletArmed(bool reused);
+	oRefVector<oBullet> _pool;
+	int _activeCount;
+	int _peakCount;
+	int _createdCount;
+	int _reusedCount;
+	friend class oBullet;
 	CC_LUA_TYPE(oBulletDef)
 };
 
@@ -38,20 +38,68 @@ void oData::apply( oWorld* world )
 	world->setShouldContact(SenseAll, Terrain, true);
 }
 
+oData::oData()
+{
+	for (int a = 0; a < GroupCount; a++)
+	{
+		for (int b = 0; b < GroupCount; b++)
+		{
+			_relations[a][b] = a == b ? oRelation::Friend : oRelation::Unkown;
+		}
+	}
+	for (int a = 0; a < DamageTypeCount; a++)
+	{
+		for (int b = 0; b < DefenceTypeCount; b++)
+		{
+			_damageFactors[a][b] = 0.0f;
+		}
+	}
+}
+
 void oData::setRelation( int groupA, int groupB, oRelation relation )
 {
-	int key = groupA<<16 | groupB;
-	_relationMap[key] = relation;
-	key = groupB | groupA<<16;
-	_relationMap[key] = relation;
+	if (groupA < 0 || groupA >= GroupCount || groupB < 0 || groupB >= GroupCount)
+	{
+		return;
+	}
+	_relations[groupA][groupB] = relation;
+	_relations[groupB][groupA] = relation;
+}
+
+void oData::setRelations( int groupA, const int groups[], int count, oRelation relation )
+{
+	for (int i = 0; i < count; i++)
+	{
+		oData::setRelation(groupA, groups[i], relation);
+	}
 }
 
 oRelation oData::getRelation( int groupA, int groupB ) const
 {
-	if (groupA == groupB) return oRelation::Friend;
-	int key = groupA<<16 | groupB;
-	auto it = _relationMap.find(key);
-	return it != _relationMap.end() ? it->second : (oRelation)oRelation::Unkown;
+	if (groupA < 0 || groupA >= GroupCount || groupB < 0 || groupB >= GroupCount)
+	{
+		return groupA == groupB ? oRelation::Friend : oRelation::Unkown;
+	}
+	return oRelation(_relations[groupA][groupB]);
+}
+
+void oData::classify( oUnit* self, oUnit* const units[], int count, oRelation relations[] ) const
+{
+	int group = self->getGroup();
+	if (group < 0 || group >= GroupCount)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			relations[i] = oData::getRelation(group, units[i]->getGroup());
+		}
+		return;
+	}
+	const uint8* row = _relations[group];
+	for (int i = 0; i < count; i++)
+	{
+		int other = units[i]->getGroup();
+		relations[i] = oRelation(other >= 0 && other < GroupCount ? row[other] : (uint8)oRelation::Unkown);
+	}
 }
 
 oRelation oData::getRelation( oUnit* unitA, oUnit* unitB ) const
@@ -87,12 +135,29 @@ oData* oData::shared()
 
 void oData::setDamageFactor( uint16 damageType, uint16 defenceType, float bounus )
 {
+	if (damageType < DamageTypeCount && defenceType < DefenceTypeCount)
+	{
+		_damageFactors[damageType][defenceType] = bounus;
+		return;
+	}
 	uint32 key = damageType | defenceType<<16;
 	_damageBounusMap[key] = bounus;
 }
 
+void oData::setDamageFactors( uint16 damageType, const float factors[], int count )
+{
+	for (int i = 0; i < count; i++)
+	{
+		oData::setDamageFactor(damageType, (uint16)i, factors[i]);
+	}
+}
+
 float oData::getDamageFactor( uint16 damageType, uint16 defenceType ) const
 {
+	if (damageType < DamageTypeCount && defenceType < DefenceTypeCount)
+	{
+		return _damageFactors[damageType][defenceType];
+	}
 	uint32 key = damageType | defenceType<<16;
 	unordered_map<uint32, float>::const_iterator it = _damageBounusMap.find(key);
 	if (it != _damageBounusMap.end())
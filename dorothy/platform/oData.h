@@ -20,21 +20,36 @@ class oUnit;
 class oData
 {
 public:
+	enum
+	{
+		GroupCount = 16,
+		DamageTypeCount = 16,
+		DefenceTypeCount = 16
+	};
+	oData();
 	void apply(oWorld* world);
 	void setRelation(int groupA, int groupB, oRelation relation);
+	/** Set the same relation between groupA and each group in groups. */
+	void setRelations(int groupA, const int groups[], int count, oRelation relation);
 	oRelation getRelation(int groupA, int groupB) const;
 	oRelation getRelation(oUnit* unitA, oUnit* unitB) const;
+	/** Get relations between self and each unit with one table row. */
+	void classify(oUnit* self, oUnit* const units[], int count, oRelation relations[]) const;
 	PROPERTY_READONLY(int, GroupHide);
 	PROPERTY_READONLY(int, GroupDetectPlayer);
 	PROPERTY_READONLY(int, GroupTerrain);
 	PROPERTY_READONLY(int, GroupDetect);
 	void setDamageFactor(uint16 damageType, uint16 defenceType, float bounus);
+	/** Set factors of the damage type against defence types from 0 to count - 1. */
+	void setDamageFactors(uint16 damageType, const float factors[], int count);
 	float getDamageFactor(uint16 damageType, uint16 defenceType) const;
 	bool isPlayer(oBody* body);
 	bool isTerrain(oBody* body);
 	static oData* shared();
 private:
-	unordered_map<int, oRelation> _relationMap;
+	uint8 _relations[GroupCount][GroupCount];
+	float _damageFactors[DamageTypeCount][DefenceTypeCount];
+	/* for the types out of the dense table */
 	unordered_map<uint32, float> _damageBounusMap;
 };
 
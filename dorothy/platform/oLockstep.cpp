@@ -0,0 +1,230 @@
+/* Copyright (c) 2013 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include "const/oDefine.h"
+#include "platform/oPlatformDefine.h"
+#include "platform/oLockstep.h"
+#include "misc/oContent.h"
+
+NS_DOROTHY_PLATFORM_BEGIN
+
+class oLockstepTicker: public CCObject
+{
+public:
+	virtual void update(float dt)
+	{
+		oLockstep::onTick();
+	}
+	static oLockstepTicker* create()
+	{
+		oLockstepTicker* ticker = new oLockstepTicker();
+		ticker->autorelease();
+		return ticker;
+	}
+};
+
+int oLockstep::_state = oLockstep::Idle;
+unsigned int oLockstep::_tick = 0;
+unsigned int oLockstep::_tickCount = 0;
+unsigned int oLockstep::_seed = 0;
+float oLockstep::_tickInterval = 1.0f/60.0f;
+size_t oLockstep::_cursor = 0;
+vector<oLockstep::oInput> oLockstep::_inputs;
+vector<oLockstep::oInput> oLockstep::_pendingInputs;
+oRef<CCObject> oLockstep::_ticker;
+oLockstepInputHandler oLockstep::inputReceived;
+
+void oLockstep::start( unsigned int seed, float tickInterval )
+{
+	_seed = seed;
+	_tickInterval = tickInterval;
+	_tickCount = 0;
+	_inputs.clear();
+	oLockstep::begin(oLockstep::Recording);
+}
+
+void oLockstep::replay()
+{
+	oLockstep::begin(oLockstep::Replaying);
+}
+
+void oLockstep::begin( int state )
+{
+	oLockstep::stop();
+	_state = state;
+	_tick = 0;
+	_cursor = 0;
+	_pendingInputs.clear();
+	oLockstep::seedRandom(_seed);
+	CCDirector* director = CCDirector::sharedDirector();
+	director->setFixedDeltaTime(_tickInterval);
+	//Ticks before all other updates so that inputs apply at the tick boundary
+	_ticker = oLockstepTicker::create();
+	director->getScheduler()->scheduleUpdateForTarget(_ticker, kCCPriorityNonSystemMin, false);
+}
+
+void oLockstep::seedRandom( unsigned int seed )
+{
+	srand(seed);
+	//LuaJIT keeps its own generator for math.random
+	ostringstream stream;
+	stream << "math.randomseed(" << seed << ')';
+	CCScriptEngine::sharedEngine()->executeString(stream.str().c_str());
+}
+
+unsigned int oLockstep::runHeadless()
+{
+	oLockstep::replay();
+	CCDirector* director = CCDirector::sharedDirector();
+	unsigned int ticks = 0;
+	while (_state == oLockstep::Replaying)
+	{
+		//Runs the Lua main loop too so that routines advance as in live play
+		director->step(_tickInterval);
+		ticks++;
+	}
+	return ticks;
+}
+
+void oLockstep::stop()
+{
+	if (_state == oLockstep::Recording)
+	{
+		_tickCount = _tick;
+	}
+	_state = oLockstep::Idle;
+	if (_ticker)
+	{
+		CCDirector* director = CCDirector::sharedDirector();
+		director->getScheduler()->unscheduleUpdateForTarget(_ticker);
+		director->setFixedDeltaTime(0.0f);
+		_ticker = nullptr;
+	}
+}
+
+void oLockstep::post( int player, int key, float value )
+{
+	if (_state == oLockstep::Recording)
+	{
+		oInput input = {0, player, key, value};
+		_pendingInputs.push_back(input);
+	}
+}
+
+void oLockstep::onTick()
+{
+	_tick++;
+	switch (_state)
+	{
+	case oLockstep::Recording:
+		for (oInput& input : _pendingInputs)
+		{
+			input.tick = _tick;
+			_inputs.push_back(input);
+			oLockstep::deliver(input);
+		}
+		_pendingInputs.clear();
+		break;
+	case oLockstep::Replaying:
+		for (; _cursor < _inputs.size() && _inputs[_cursor].tick <= _tick; _cursor++)
+		{
+			oLockstep::deliver(_inputs[_cursor]);
+		}
+		if (_tick >= _tickCount)
+		{
+			oLockstep::stop();
+		}
+		break;
+	}
+}
+
+void oLockstep::deliver( const oInput& input )
+{
+	if (inputReceived)
+	{
+		inputReceived(input.player, input.key, input.value);
+	}
+}
+
+bool oLockstep::save( const char* filename )
+{
+	if (_state == oLockstep::Recording)
+	{
+		_tickCount = _tick;
+	}
+	ostringstream stream;
+	stream.precision(9);
+	stream << _seed << ' ' << _tickInterval << ' ' << _tickCount << ' ' << _inputs.size() << '\n';
+	for (const oInput& input : _inputs)
+	{
+		stream << input.tick << ' ' << input.player << ' ' << input.key << ' ' << input.value << '\n';
+	}
+	string content = stream.str();
+	FILE* file = fopen(oSharedContent.getFullPath(filename).c_str(), "wb");
+	if (file == nullptr) return false;
+	bool written = fwrite(content.c_str(), 1, content.size(), file) == content.size();
+	bool closed = fclose(file) == 0;
+	return written && closed;
+}
+
+bool oLockstep::load( const char* filename )
+{
+	unsigned long size = 0;
+	oOwnArray<char> data = oSharedContent.loadFile(filename, size);
+	if (data == nullptr) return false;
+	std::istringstream stream(string(data, size));
+	size_t count = 0;
+	unsigned int seed, tickCount;
+	float tickInterval;
+	if (!(stream >> seed >> tickInterval >> tickCount >> count)) return false;
+	//Each input takes at least 8 chars, a larger count is a broken log
+	if (count > size / 8 || !(tickInterval > 0.0f)) return false;
+	vector<oInput> inputs(count);
+	for (oInput& input : inputs)
+	{
+		if (!(stream >> input.tick >> input.player >> input.key >> input.value)) return false;
+	}
+	oLockstep::stop();
+	_seed = seed;
+	_tickInterval = tickInterval;
+	_tickCount = tickCount;
+	_inputs = std::move(inputs);
+	return true;
+}
+
+int oLockstep::getState()
+{
+	return _state;
+}
+
+unsigned int oLockstep::getTick()
+{
+	return _tick;
+}
+
+unsigned int oLockstep::getTickCount()
+{
+	return _state == oLockstep::Recording ? _tick : _tickCount;
+}
+
+unsigned int oLockstep::getSeed()
+{
+	return _seed;
+}
+
+float oLockstep::getTickInterval()
+{
+	return _tickInterval;
+}
+
+const vector<oLockstep::oInput>& oLockstep::getInputs()
+{
+	return _inputs;
+}
+
+NS_DOROTHY_PLATFORM_END
\ No newline at end of file
@@ -0,0 +1,79 @@
+/* Copyright (c) 2013 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#ifndef __DOROTHY_PLATFORM_OLOCKSTEP_H__
+#define __DOROTHY_PLATFORM_OLOCKSTEP_H__
+
+NS_DOROTHY_PLATFORM_BEGIN
+
+typedef Delegate<void (int player, int key, float value)> oLockstepInputHandler;
+
+/** @brief Deterministic simulation for replays and netplay.
+ While running, the director advances game time by a fixed tick, the
+ AI frame budget is ignored, and both the C random generator used by
+ particles and AI and math.random of scripts are seeded.
+ Inputs posted during a tick are delivered at the start of the next tick
+ and recorded, so a saved log replays the same simulation when the game
+ rebuilds its initial scene right after starting the replay.
+*/
+class oLockstep
+{
+public:
+	enum {Idle, Recording, Replaying};
+	struct oInput
+	{
+		unsigned int tick;
+		int player;
+		int key;
+		float value;
+	};
+	/** Start recording a new log from tick 0. */
+	static void start(unsigned int seed, float tickInterval = 1.0f/60.0f);
+	/** Replay the current log in real time from tick 0. */
+	static void replay();
+	/**
+	 Replay the current log without rendering as fast as possible.
+	 Do not call it from scheduled updates, the scheduler is not reentrant.
+	 Returns the number of ticks run.
+	 */
+	static unsigned int runHeadless();
+	static void stop();
+	/** Post an input, ignored while replaying. */
+	static void post(int player, int key, float value);
+	/** Returns false when the file can not be written. */
+	static bool save(const char* filename);
+	/** Returns false and keeps the current log when the file is missing or broken. */
+	static bool load(const char* filename);
+	static int getState();
+	static unsigned int getTick();
+	static unsigned int getTickCount();
+	static unsigned int getSeed();
+	static float getTickInterval();
+	static const vector<oInput>& getInputs();
+	/** Seed the C random generator and math.random of scripts. */
+	static void seedRandom(unsigned int seed);
+	static oLockstepInputHandler inputReceived;
+private:
+	static void begin(int state);
+	static void onTick();
+	static void deliver(const oInput& input);
+	static int _state;
+	static unsigned int _tick;
+	static unsigned int _tickCount;
+	static unsigned int _seed;
+	static float _tickInterval;
+	static size_t _cursor;
+	static vector<oInput> _inputs;
+	static vector<oInput> _pendingInputs;
+	static oRef<CCObject> _ticker;
+	friend class oLockstepTicker;
+};
+
+NS_DOROTHY_PLATFORM_END
+
+#endif // __DOROTHY_PLATFORM_OLOCKSTEP_H__
\ No newline at end of file
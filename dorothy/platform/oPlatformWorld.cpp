@@ -126,6 +126,19 @@ bool oPlatformWorld::init()
 	return true;
 }
 
+void oPlatformWorld::update( float dt )
+{
+	oWorld::update(dt);
+	/* the world step is what moves units, also in headless runs
+	 where the director does not count frames */
+	_unitGrid.markDirty();
+}
+
+oUnitGrid* oPlatformWorld::getUnitGrid()
+{
+	return &_unitGrid;
+}
+
 oCamera* oPlatformWorld::getCamera() const
 {
 	return _camera;
@@ -11,6 +11,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #include "physics/oWorld.h"
 #include "misc/oNode3D.h"
+#include "platform/oUnitGrid.h"
 
 NS_DOROTHY_PLATFORM_BEGIN
 
@@ -42,6 +43,7 @@ public:
 	virtual void reorderChild(CCNode * child, int zOrder);
 	virtual void removeChild(CCNode* child, bool cleanup);
 	virtual CCNode* getChildByTag(int tag);
+	virtual void update(float dt);
 	virtual void draw();
 	oLayer* getLayer(int zOrder);
 	void removeLayer(int zOrder);
@@ -52,8 +54,11 @@ public:
 	void setLayerOffset(int zOrder, const oVec2& offset);
 	const oVec2& getLayerOffset(int zOrder);
 	void onCameraMoved(float deltaX, float deltaY);
+	/** Grid of units in this world for perception queries. */
+	oUnitGrid* getUnitGrid();
 	CREATE_FUNC(oPlatformWorld);
 private:
+	oUnitGrid _unitGrid;
 	oCamera* _camera;
 	CCNode* _layerUI;
 	oLayerMap _layers;
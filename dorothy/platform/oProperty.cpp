@@ -9,14 +9,57 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include "const/oDefine.h"
 #include "platform/oPlatformDefine.h"
 #include "platform/oProperty.h"
+#include "misc/oIdTable.h"
 
 NS_DOROTHY_PLATFORM_BEGIN
 
+static oIdTable& oGetPropertyNames()
+{
+	static oIdTable names;
+	if (names.getCount() == 0)
+	{
+		names.getId(string("hp"));
+	}
+	return names;
+}
+
+int oProperty::getId( const string& name )
+{
+	return oGetPropertyNames().getId(name);
+}
+
+int oProperty::getId( const char* name )
+{
+	return oGetPropertyNames().getId(name);
+}
+
+int oProperty::find( const string& name )
+{
+	return oGetPropertyNames().find(name);
+}
+
+const string& oProperty::getName( int id )
+{
+	return oGetPropertyNames().getName(id);
+}
+
+int oProperty::getIdCount()
+{
+	return oGetPropertyNames().getCount();
+}
+
 oProperty::oProperty( oUnit* owner, float data ):
 _owner(owner),
 _data(data)
 { }
 
+void oProperty::init( oUnit* owner, float data )
+{
+	_owner = owner;
+	_data = data;
+	changed.Clear();
+}
+
 void oProperty::reset( float value )
 {
 	_data = value;
@@ -18,7 +18,8 @@ typedef Delegate<void (oUnit* owner, float oldValue, float newValue)> oPropertyH
 class oProperty
 {
 public:
-	explicit oProperty(oUnit* owner, float data = 0.0f);
+	enum {HP = 0};
+	explicit oProperty(oUnit* owner = nullptr, float data = 0.0f);
 	oProperty(const oProperty& prop);
 	oUnit* getOwner() const;
 	/** Change its value and not let others know. */
@@ -34,9 +35,21 @@ public:
 	operator float() const;
 	/** Change its value and notice others. */
 	oPropertyHandler changed;
+	/** Property names are interned to small ids shared by all units,
+	 id 0 is always the default property "hp".
+	*/
+	static int getId(const string& name);
+	/** Lookup cached by the string address, for names passed from scripts. */
+	static int getId(const char* name);
+	/** Get the id without interning, returns -1 when the name is unknown. */
+	static int find(const string& name);
+	static const string& getName(int id);
+	static int getIdCount();
 private:
+	void init(oUnit* owner, float data);
 	oUnit* _owner;
 	float _data;
+	friend class oUnit;
 };
 
 NS_DOROTHY_PLATFORM_END
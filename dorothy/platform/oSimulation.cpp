@@ -0,0 +1,252 @@
+/* Copyright (c) 2013 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include "const/oDefine.h"
+#include "platform/oPlatformDefine.h"
+#include "platform/oSimulation.h"
+#include "platform/oPlatformWorld.h"
+#include "platform/oUnit.h"
+#include "platform/oUnitDef.h"
+#include "platform/oAction.h"
+#include "platform/oProperty.h"
+#include "platform/oAI.h"
+#include "platform/oLockstep.h"
+#include "misc/oContent.h"
+#include <algorithm>
+
+NS_DOROTHY_PLATFORM_BEGIN
+
+const char* oSimulation::CSVHeader = "seed,unit,name,group,damageDealt,damageTaken,killTime,actions\n";
+
+oSimulation::oSimulation( unsigned int seed ):
+tickInterval(1.0f/60.0f),
+timeLimit(120.0f),
+_seed(seed),
+_time(0.0f)
+{ }
+
+oSimulation::~oSimulation()
+{
+	oSimulation::unhook();
+}
+
+bool oSimulation::init()
+{
+	_world = oPlatformWorld::create();
+	return true;
+}
+
+oPlatformWorld* oSimulation::getWorld() const
+{
+	return _world;
+}
+
+unsigned int oSimulation::getSeed() const
+{
+	return _seed;
+}
+
+float oSimulation::getTime() const
+{
+	return _time;
+}
+
+void oSimulation::track( oUnit* unit )
+{
+	if (oSimulation::getStats(unit)) return;
+	oUnitStats* stats = new oUnitStats();
+	stats->unit = unit;
+	stats->damageDealt = 0.0f;
+	stats->damageTaken = 0.0f;
+	stats->killTime = -1.0f;
+	_stats.push_back(oOwnMake(stats));
+	unit->properties[oProperty::HP].changed += std::make_pair(this, &oSimulation::onHpChanged);
+	unit->actionAdded += std::make_pair(this, &oSimulation::onActionAdded);
+	unit->eachAction(std::make_pair(this, &oSimulation::hookAction));
+}
+
+void oSimulation::unhook()
+{
+	for (const auto& stats : _stats)
+	{
+		oUnit* unit = stats->unit;
+		unit->properties[oProperty::HP].changed -= std::make_pair(this, &oSimulation::onHpChanged);
+		unit->actionAdded -= std::make_pair(this, &oSimulation::onActionAdded);
+		unit->eachAction([this](oAction* action)
+		{
+			action->actionStart -= std::make_pair(this, &oSimulation::onActionStart);
+			oAttack* attack = dynamic_cast<oAttack*>(action);
+			if (attack)
+			{
+				attack->damaged -= std::make_pair(this, &oSimulation::onDamaged);
+			}
+		});
+	}
+}
+
+void oSimulation::hookAction( oAction* action )
+{
+	action->actionStart += std::make_pair(this, &oSimulation::onActionStart);
+	oAttack* attack = dynamic_cast<oAttack*>(action);
+	if (attack)
+	{
+		attack->damaged += std::make_pair(this, &oSimulation::onDamaged);
+	}
+}
+
+void oSimulation::onActionAdded( oAction* action )
+{
+	if (action)
+	{
+		oSimulation::hookAction(action);
+	}
+}
+
+oSimulation::oUnitStats* oSimulation::getStats( oUnit* unit )
+{
+	for (const auto& stats : _stats)
+	{
+		if (stats->unit == unit) return stats;
+	}
+	return nullptr;
+}
+
+void oSimulation::onActionStart( oAction* action )
+{
+	oUnitStats* stats = oSimulation::getStats(action->getOwner());
+	if (stats)
+	{
+		stats->actionCounts[action->getName()]++;
+	}
+}
+
+void oSimulation::onDamaged( oUnit* source, oUnit* target, float damage )
+{
+	oUnitStats* stats = oSimulation::getStats(source);
+	if (stats) stats->damageDealt += damage;
+	stats = oSimulation::getStats(target);
+	if (stats) stats->damageTaken += damage;
+}
+
+void oSimulation::onHpChanged( oUnit* unit, float oldValue, float newValue )
+{
+	oUnitStats* stats = oSimulation::getStats(unit);
+	if (stats && stats->killTime < 0.0f && newValue <= 0.0f)
+	{
+		stats->killTime = _time;
+	}
+}
+
+bool oSimulation::isDecided() const
+{
+	int aliveGroup = -1;
+	for (const auto& stats : _stats)
+	{
+		if (stats->killTime >= 0.0f) continue;
+		int group = stats->unit->getGroup();
+		if (aliveGroup < 0)
+		{
+			aliveGroup = group;
+		}
+		else if (aliveGroup != group)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+float oSimulation::run()
+{
+	CCDirector* director = CCDirector::sharedDirector();
+	oRef<oSimulation> self(this);
+	//Seed here since scripts may draw random numbers between init and run
+	oLockstep::seedRandom(_seed);
+	//Wall clock budgets defer different reflexes in every run
+	float frameBudget = oAI::frameBudget;
+	oAI::frameBudget = 0.0f;
+	if (!_world->isRunning())
+	{
+		_world->onEnter();
+		_world->onEnterTransitionDidFinish();
+	}
+	while (_time < timeLimit && !oSimulation::isDecided())
+	{
+		//Kills during this tick are stamped with the time at its end
+		_time += tickInterval;
+		director->step(tickInterval);
+	}
+	_world->onExitTransitionDidStart();
+	_world->onExit();
+	oAI::frameBudget = frameBudget;
+	return _time;
+}
+
+static string oCSVField(const string& text)
+{
+	if (text.find_first_of(",\"\r\n") == string::npos)
+	{
+		return text;
+	}
+	string field = "\"";
+	for (char ch : text)
+	{
+		if (ch == '"') field += '"';
+		field += ch;
+	}
+	field += '"';
+	return field;
+}
+
+string oSimulation::getCSV( bool withHeader ) const
+{
+	ostringstream stream;
+	if (withHeader)
+	{
+		stream << oSimulation::CSVHeader;
+	}
+	for (size_t i = 0; i < _stats.size(); i++)
+	{
+		const oUnitStats* stats = _stats[i];
+		stream << _seed << ',' << i << ',' << oCSVField(stats->unit->getUnitDef()->name) << ','
+			<< stats->unit->getGroup() << ',' << stats->damageDealt << ',' << stats->damageTaken << ','
+			<< stats->killTime << ',';
+		//Sort by name so rows of the same seed are identical
+		vector<std::pair<string, int>> counts(stats->actionCounts.begin(), stats->actionCounts.end());
+		std::sort(counts.begin(), counts.end());
+		ostringstream actions;
+		for (size_t n = 0; n < counts.size(); n++)
+		{
+			actions << (n == 0 ? "" : ";") << counts[n].first << '=' << counts[n].second;
+		}
+		stream << oCSVField(actions.str()) << '\n';
+	}
+	return stream.str();
+}
+
+bool oSimulation::saveCSV( const char* filename ) const
+{
+	string fullName = oSharedContent.getFullPath(filename);
+	bool exist = oSharedContent.isFileExist(fullName.c_str());
+	FILE* file = fopen(fullName.c_str(), "a");
+	if (file == nullptr) return false;
+	string content = oSimulation::getCSV(!exist);
+	bool written = fwrite(content.c_str(), 1, content.size(), file) == content.size();
+	bool closed = fclose(file) == 0;
+	return written && closed;
+}
+
+oSimulation* oSimulation::create( unsigned int seed )
+{
+	oSimulation* simulation = new oSimulation(seed);
+	CC_INIT(simulation);
+	simulation->autorelease();
+	return simulation;
+}
+
+NS_DOROTHY_PLATFORM_END
\ No newline at end of file
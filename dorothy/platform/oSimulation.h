@@ -0,0 +1,78 @@
+/* Copyright (c) 2013 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#ifndef __DOROTHY_PLATFORM_OSIMULATION_H__
+#define __DOROTHY_PLATFORM_OSIMULATION_H__
+
+NS_DOROTHY_PLATFORM_BEGIN
+
+class oPlatformWorld;
+class oUnit;
+class oAction;
+
+/** @brief Runs a platform world without rendering for balance testing.
+ The world is never added to a scene, run() steps the director by a fixed
+ tick, Lua routines included, as fast as possible until one group of tracked units remains or the
+ time limit is reached. The scheduler is shared by the whole process, so
+ run independent simulations in separate processes with different seeds.
+ Unit defs used here should not load models that need a GL context.
+*/
+class oSimulation: public CCObject
+{
+public:
+	virtual ~oSimulation();
+	PROPERTY_READONLY(oPlatformWorld*, World);
+	PROPERTY_READONLY(unsigned int, Seed);
+	PROPERTY_READONLY(float, Time);
+	float tickInterval;
+	float timeLimit;
+	/** Collect damage, kill time and action counts of the unit. */
+	void track(oUnit* unit);
+	/**
+	 Seeds rand() and math.random with the seed, then runs with the AI
+	 frame budget off. Returns the simulated time in seconds.
+	 Do not call it from scheduled updates, it ticks the shared scheduler
+	 which is not reentrant.
+	 */
+	float run();
+	/** One row for each tracked unit, actions are sorted by name. */
+	string getCSV(bool withHeader) const;
+	/** Append rows to the file, writes the header for a new file. */
+	bool saveCSV(const char* filename) const;
+	static const char* CSVHeader;
+	static oSimulation* create(unsigned int seed);
+protected:
+	oSimulation(unsigned int seed);
+	virtual bool init();
+private:
+	struct oUnitStats
+	{
+		oRef<oUnit> unit;
+		float damageDealt;
+		float damageTaken;
+		float killTime;
+		unordered_map<string, int> actionCounts;
+	};
+	oUnitStats* getStats(oUnit* unit);
+	void hookAction(oAction* action);
+	void onActionAdded(oAction* action);
+	void onActionStart(oAction* action);
+	void onDamaged(oUnit* source, oUnit* target, float damage);
+	void onHpChanged(oUnit* unit, float oldValue, float newValue);
+	bool isDecided() const;
+	void unhook();
+	oRef<oPlatformWorld> _world;
+	unsigned int _seed;
+	float _time;
+	vector<oOwn<oUnitStats>> _stats;
+	CC_LUA_TYPE(oSimulation)
+};
+
+NS_DOROTHY_PLATFORM_END
+
+#endif // __DOROTHY_PLATFORM_OSIMULATION_H__
\ No newline at end of file
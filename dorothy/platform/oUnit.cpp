@@ -15,6 +15,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include "platform/oAINode.h"
 #include "platform/oAI.h"
 #include "platform/oPlatformWorld.h"
+#include "platform/oUnitBatch.h"
 
 #include "model/oModelDef.h"
 #include "model/oModel.h"
@@ -29,6 +30,11 @@ _model(nullptr),
 _detectSensor(nullptr),
 _attackSensor(nullptr),
 _currentAction(nullptr),
+_reflexRequest(oUnit::NoReflex),
+_thinkDelta(CCRANDOM_0_1() * oAI::thinkInterval),
+_gridIndex(-1),
+_batchIndex(-1),
+_batched(false),
 _size(unitDef->getSize()),
 move(unitDef->move),
 moveSpeed(1.0f),
@@ -65,16 +71,20 @@ bool oUnit::init()
 	model->setScaleY(_unitDef->getScale());
 	oUnit::setModel(model);
 	oBody::setOwner(this);
-	for (const string& name : _unitDef->actions)
+	for (int id : _unitDef->actions)
 	{
-		oUnit::attachAction(name);
+		oUnit::attachAction(id);
 	}
 	for (int id : _unitDef->instincts)
 	{
 		oUnit::attachInstinct(id);
 	}
 	oUnit::setReflexArc(_unitDef->reflexArc);
-	this->scheduleUpdate();
+	_batched = _unitDef->batchUpdate;
+	if (!_batched)
+	{
+		this->scheduleUpdate();
+	}
 	return true;
 }
 
@@ -132,22 +142,67 @@ oUnit* oUnit::create(oUnitDef* unitDef, oWorld* world, const oVec2& pos, float r
 	return unit;
 }
 
+void oUnit::onEnter()
+{
+	oBody::onEnter();
+	oPlatformWorld* world = CCLuaCast<oPlatformWorld>(oBody::getWorld());
+	if (world)
+	{
+		world->getUnitGrid()->add(this);
+	}
+	if (_batched)
+	{
+		_unitDef->getBatch()->add(this);
+	}
+}
+
+void oUnit::onExit()
+{
+	oBody::onExit();
+	oPlatformWorld* world = CCLuaCast<oPlatformWorld>(oBody::getWorld());
+	if (world)
+	{
+		world->getUnitGrid()->remove(this);
+	}
+	if (_batched)
+	{
+		_unitDef->getBatch()->remove(this);
+	}
+}
+
 void oUnit::update( float dt )
 {
 	if (!_bodyB2->IsActive()) return;
+	if (!_batched)
+	{
+		_thinkDelta = oUnit::updateReflex(dt, _thinkDelta);
+	}
+	oBody::update(dt);
+}
+
+float oUnit::updateReflex( float dt, float thinkDelta )
+{
 	if (_currentAction != nullptr)
 	{
 		_currentAction->update(dt);
 		if (_currentAction && !_currentAction->isDoing())
 		{
 			_currentAction = nullptr;
+			oAI::requestReflex(this, true);
 		}
 	}
 	else
 	{
-		oAI::conditionedReflex(this);
+		/* idle units think at intervals with random phases
+		 so that their evaluations spread across frames */
+		thinkDelta += dt;
+		if (thinkDelta >= oAI::thinkInterval)
+		{
+			thinkDelta = 0.0f;
+			oAI::requestReflex(this);
+		}
 	}
-	oBody::update(dt);
+	return thinkDelta;
 }
 
 void oUnit::setGroup( int group )
@@ -163,7 +218,7 @@ void oUnit::setGroup( int group )
 				continue;
 			}
 		}
-		f->SetFilterData(oBody::getWorld()->getFilter(group));
+		oBody::getWorld()->setFixtureGroup(f, group);
 	}
 }
 
@@ -179,26 +234,38 @@ float oUnit::getHeight() const
 
 oAction* oUnit::attachAction( const string& name )
 {
-	auto it = _actions.find(name);
-	if (it == _actions.end())
+	return oUnit::attachAction(oAction::getId(name));
+}
+
+oAction* oUnit::attachAction( int id )
+{
+	oAction* action = oUnit::getAction(id);
+	if (action == nullptr)
 	{
-		oAction* action = oAction::create(name, this);
+		action = oAction::create(id, this);
 		if (action)
 		{
-			_actions[name] = oOwnMake(action);
+			if ((int)_actions.size() <= id)
+			{
+				_actions.resize(id + 1);
+			}
+			_actions[id] = oOwnMake(action);
 		}
 		actionAdded(action);
-		return action;
 	}
-	return it->second;
+	return action;
 }
 
 void oUnit::removeAction( const string& name )
 {
-	auto it = _actions.find(name);
-	if (it != _actions.end())
+	oUnit::removeAction(oAction::getId(name));
+}
+
+void oUnit::removeAction( int id )
+{
+	if (0 <= id && id < (int)_actions.size())
 	{
-		_actions.erase(it);
+		_actions[id] = nullptr;
 	}
 }
 
@@ -209,24 +276,35 @@ void oUnit::removeAllActions()
 
 oAction* oUnit::getAction( const string& name ) const
 {
-	auto it = _actions.find(name);
-	return it == _actions.end() ? nullptr : it->second.get();
+	return oUnit::getAction(oAction::getId(name));
+}
+
+oAction* oUnit::getAction( int id ) const
+{
+	return 0 <= id && id < (int)_actions.size() ? _actions[id].get() : nullptr;
 }
 
 void oUnit::eachAction(const oActionHandler& func)
 {
-	for (const auto& pair : _actions)
+	for (const auto& action : _actions)
 	{
-		func(pair.second);
+		if (action)
+		{
+			func(action);
+		}
 	}
 }
 
 bool oUnit::start( const string& name )
 {
-	auto it = _actions.find(name);
-	if (it != _actions.end())
+	return oUnit::start(oAction::getId(name));
+}
+
+bool oUnit::start( int id )
+{
+	oAction* action = oUnit::getAction(id);
+	if (action)
 	{
-		oAction* action = it->second;
 		if (action->isDoing()) return true;
 		if (action->isAvailable())
 		{
@@ -261,9 +339,14 @@ void oUnit::stop()
 	}
 }
 
-bool oUnit::isDoing(const string &name)
+bool oUnit::isDoing( const string& name )
 {
-	return _currentAction && _currentAction->getName() == name && _currentAction->isDoing();
+	return oUnit::isDoing(oAction::getId(name));
+}
+
+bool oUnit::isDoing( int id )
+{
+	return _currentAction && _currentAction->getId() == id && _currentAction->isDoing();
 }
 
 bool oUnit::isOnSurface() const
@@ -283,6 +366,7 @@ void oUnit::setDetectDistance(float var)
 	{
 		_detectSensor = oBody::attachSensor(oUnitDef::DetectSensorTag, oBodyDef::circle(var));
 		_detectSensor->setGroup(oSharedData.getGroupDetectPlayer());
+		_detectSensor->bodyEnter += std::make_pair(this, &oUnit::onDetectEnter);
 	}
 }
 
@@ -316,6 +400,14 @@ oSensor* oUnit::getGroundSensor() const
 	return _groundSensor;
 }
 
+void oUnit::onDetectEnter( oSensor* sensor, oBody* body )
+{
+	if (!_currentAction && CCLuaCast<oUnit>(body->getOwner()))
+	{
+		oAI::requestReflex(this, true);
+	}
+}
+
 oSensor* oUnit::getDetectSensor() const
 {
 	return _detectSensor;
@@ -342,61 +434,93 @@ oAction* oUnit::getCurrentAction() const
 }
 
 // oPropertySet
-oUnit::oPropertySet::~oPropertySet()
-{
-	for (auto it : _items) delete it.second;
-}
-
 void oUnit::oPropertySet::operator()(oUnit* owner)
 {
 	_owner = owner;
-	_items["hp"] = new oProperty(_owner, _owner->maxHp);//Add the default property "hp"
+	oPropertySet::add(oProperty::HP)->reset(_owner->maxHp);//Add the default property "hp"
 }
 oProperty& oUnit::oPropertySet::operator[]( const string& name )
 {
-	return *(oPropertySet::add(name));
+	return *(oPropertySet::add(oProperty::getId(name)));
 }
 const oProperty& oUnit::oPropertySet::operator[]( const string& name ) const
 {
-	return *(_items.find(name)->second);
+	// reading an unknown name should not intern it
+	return (*this)[oProperty::find(name)];
+}
+oProperty& oUnit::oPropertySet::operator[]( int id )
+{
+	oProperty* prop = oPropertySet::add(id);
+	CCAssert(prop, "Invalid property id, use add(id) for ids from scripts.");
+	return *prop;
+}
+const oProperty& oUnit::oPropertySet::operator[]( int id ) const
+{
+	static const oProperty none;
+	oProperty* prop = oPropertySet::get(id);
+	return prop ? *prop : none;
 }
 void oUnit::oPropertySet::remove( const string& name )
 {
-	if (name != "hp")
+	oPropertySet::remove(oProperty::getId(name));
+}
+void oUnit::oPropertySet::remove( int id )
+{
+	oProperty* prop = oPropertySet::get(id);
+	if (prop && id != oProperty::HP)
 	{
-		auto it = _items.find(name);
-		if (it != _items.end())
-		{
-			_items.erase(it);
-		}
+		_present[id] = false;
+		prop->init(_owner, 0.0f);
 	}
 }
 void oUnit::oPropertySet::clear()
 {
-	float temp = *_items["hp"];
-	_items.clear();
-	for (auto it : _items) delete it.second;
-	_items["hp"] = new oProperty(_owner, temp);//Add the default property "hp"
+	for (int id = 0; id < (int)_present.size(); id++)
+	{
+		oPropertySet::remove(id);
+	}
 }
 oProperty* oUnit::oPropertySet::add( const string& name )
 {
-	auto it = _items.find(name);
-	if (it != _items.end())
+	return oPropertySet::add(oProperty::getId(name));
+}
+oProperty* oUnit::oPropertySet::add( int id )
+{
+	if (id < 0 || id >= oProperty::getIdCount())
 	{
-		return it->second;
+		return nullptr;
 	}
-	else
+	oProperty* prop = oPropertySet::get(id);
+	if (prop)
 	{
-		oProperty* prop = new oProperty(_owner);
-		_items[name] = prop;
-		_owner->_instincts.reinstall();
 		return prop;
 	}
+	while ((int)_chunks.size()*ChunkSize <= id)
+	{
+		oProperty* chunk = new oProperty[ChunkSize];
+		for (int i = 0; i < ChunkSize; i++)
+		{
+			chunk[i].init(_owner, 0.0f);
+		}
+		_chunks.push_back(oOwnArray<oProperty>(chunk));
+		_present.resize(_chunks.size()*ChunkSize, false);
+	}
+	_present[id] = true;
+	prop = &_chunks[id / ChunkSize][id % ChunkSize];
+	_owner->_instincts.reinstall();
+	return prop;
 }
 oProperty* oUnit::oPropertySet::get( const string& name ) const
 {
-	auto it = _items.find(name);
-	return it == _items.end() ? nullptr : it->second;
+	return oPropertySet::get(oProperty::find(name));
+}
+oProperty* oUnit::oPropertySet::get( int id ) const
+{
+	if (0 <= id && id < (int)_present.size() && _present[id])
+	{
+		return &_chunks[id / ChunkSize][id % ChunkSize];
+	}
+	return nullptr;
 }
 
 // oInstinctSet
@@ -456,17 +580,32 @@ oAILeaf* oUnit::getReflexArcNode()
 
 void oUnit::set( const char* name, float value )
 {
-	properties[name] = value;
+	properties[oProperty::getId(name)] = value;
 }
 
 float oUnit::get( const char* name )
 {
-	return *(properties.add(name));
+	return *(properties.add(oProperty::getId(name)));
+}
+
+void oUnit::set( int id, float value )
+{
+	oProperty* prop = properties.add(id);
+	if (prop)
+	{
+		*prop = value;
+	}
+}
+
+float oUnit::get( int id )
+{
+	oProperty* prop = properties.add(id);
+	return prop ? *prop : 0.0f;
 }
 
 void oUnit::remove( const char* name )
 {
-	properties.remove(name);
+	properties.remove(oProperty::getId(name));
 }
 
 void oUnit::clear()
@@ -474,6 +613,11 @@ void oUnit::clear()
 	properties.clear();
 }
 
+int oUnit::getPropertyId( const char* name )
+{
+	return oProperty::getId(name);
+}
+
 void oUnit::attachInstinct( int id )
 {
 	oInstinct* instinct = oInstinct::get(id);
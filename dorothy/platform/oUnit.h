@@ -29,8 +29,7 @@ typedef Delegate<void (oAction* action)> oActionHandler;
 
 class oUnit: public oBody
 {
-	typedef unordered_map<string, oOwn<oAction>> oActionMap;
-	typedef unordered_map<string, oProperty*> oPropertyMap;
+	typedef vector<oOwn<oAction>> oActionList;
 public:
 	//Class properties
 	PROPERTY_NAME(oModel*, Model);
@@ -47,44 +46,65 @@ public:
 	PROPERTY_READONLY(float, Height);
 	//
 	virtual bool init();
+	virtual void onEnter();
+	virtual void onExit();
 	virtual void setGroup( int group );
 	virtual void update( float dt );
 	//Actions
 	oAction* attachAction(const string& name);
+	oAction* attachAction(int id);
 	void removeAction(const string& name);
+	void removeAction(int id);
 	void removeAllActions();
 	oAction* getAction(const string& name) const;
+	oAction* getAction(int id) const;
 	void eachAction(const oActionHandler& func);
 	oActionHandler actionAdded;
 
 	bool start(const string& name);
+	bool start(int id);
 	void stop();
 	bool isDoing(const string& name);
+	bool isDoing(int id);
 	//
 	bool isOnSurface() const;
 
 	//Named properties
+	/** Values are stored inline in chunks indexed by interned property ids,
+	 addresses stay valid while the property exists.
+	 Ids not interned by oProperty::getId are rejected, add returns nullptr.
+	*/
 	class oPropertySet
 	{
 	public:
-		~oPropertySet();
 		oProperty& operator[](const string& name);
 		const oProperty& operator[](const string& name) const;
+		/** The id must be interned, add(id) returns nullptr for others. */
+		oProperty& operator[](int id);
+		const oProperty& operator[](int id) const;
 		oProperty* add(const string& name);
+		oProperty* add(int id);
 		oProperty* get(const string& name) const;
+		oProperty* get(int id) const;
 		void remove(const string& name);
+		void remove(int id);
 		void clear();
 	private:
+		enum {ChunkSize = 16};
 		void operator()(oUnit* owner);
 		oUnit* _owner;
-		oPropertyMap _items;
+		vector<oOwnArray<oProperty>> _chunks;
+		vector<bool> _present;
 		friend class oUnit;
 	} properties;
 	//Methods for script to use properties
 	void set(const char* name, float value);
 	float get(const char* name);
+	void set(int id, float value);
+	float get(int id);
 	void remove(const char* name);
 	void clear();
+	static int getPropertyId(const char* name);
 	//Dynamic properties
 	float sensity;
 	float move;
@@ -128,6 +148,15 @@ protected:
 		friend class oUnit;
 	} _instincts;
 private:
+	void onDetectEnter(oSensor* sensor, oBody* body);
+	/** Update current action and think timer, returns the new think timer. */
+	float updateReflex(float dt, float thinkDelta);
+	enum { NoReflex, NormalReflex, UrgentReflex };
+	int _reflexRequest;
+	float _thinkDelta;
+	int _gridIndex;
+	int _batchIndex;
+	bool _batched;
 	string _reflexArcName;
 	oRef<oUnitDef> _unitDef;
 	oRef<oAILeaf> _reflexArc;
@@ -138,7 +167,10 @@ private:
 	oSensor* _detectSensor;
 	oSensor* _attackSensor;
 	oAction* _currentAction;
-	oActionMap _actions;
+	oActionList _actions;//Indexed by action id
+	friend class oAI;
+	friend class oUnitGrid;
+	friend class oUnitBatch;
 	CC_LUA_TYPE(oUnit)
 };
 
@@ -0,0 +1,253 @@
+/* Copyright (c) 2013 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include "const/oDefine.h"
+#include "platform/oPlatformDefine.h"
+#include "platform/oUnitBatch.h"
+#include "platform/oUnit.h"
+#include "platform/oUnitDef.h"
+#include "platform/oAction.h"
+#include "platform/oAI.h"
+
+NS_DOROTHY_PLATFORM_BEGIN
+
+oUnitBatch::oUnitBatch():
+_unitCount(0),
+_updating(false),
+_dirty(false)
+{ }
+
+oUnitBatch::~oUnitBatch()
+{
+	for (oUnit* unit : _units)
+	{
+		if (unit) unit->_batchIndex = -1;
+	}
+	CCDirector::sharedDirector()->getScheduler()->unscheduleUpdateForTarget(this);
+}
+
+void oUnitBatch::push( oUnit* unit )
+{
+	//Units may join while acting, take over the state of their current action
+	oAction* action = unit->_currentAction;
+	bool acting = action && action->isDoing();
+	bool walking = acting && action->getId() == oID::ActionWalkId;
+	unit->_batchIndex = (int)_units.size();
+	_units.push_back(unit);
+	_thinkDeltas.push_back(unit->_thinkDelta);
+	_states.push_back(walking ? Walking : (acting ? Acting : Idle));
+	_reactionTimes.push_back(acting ? unit->sensity * action->reaction : -1.0f);
+	_reactionDeltas.push_back(0.0f);
+	_walkElapsed.push_back(walking ? action->recovery : 0.0f);
+	_walkRecoveries.push_back(walking ? action->recovery : 0.0f);
+	_moveIntents.push_back(0.0f);
+}
+
+void oUnitBatch::move( int from, int to )
+{
+	_units[to] = _units[from];
+	_thinkDeltas[to] = _thinkDeltas[from];
+	_states[to] = _states[from];
+	_reactionTimes[to] = _reactionTimes[from];
+	_reactionDeltas[to] = _reactionDeltas[from];
+	_walkElapsed[to] = _walkElapsed[from];
+	_walkRecoveries[to] = _walkRecoveries[from];
+	_moveIntents[to] = _moveIntents[from];
+	if (_units[to]) _units[to]->_batchIndex = to;
+}
+
+void oUnitBatch::resize( int count )
+{
+	_units.resize(count);
+	_thinkDeltas.resize(count);
+	_states.resize(count);
+	_reactionTimes.resize(count);
+	_reactionDeltas.resize(count);
+	_walkElapsed.resize(count);
+	_walkRecoveries.resize(count);
+	_moveIntents.resize(count);
+}
+
+void oUnitBatch::add( oUnit* unit )
+{
+	if (unit->_batchIndex >= 0) return;
+	oUnitBatch::push(unit);
+	if (_unitCount++ == 0)
+	{
+		CCDirector::sharedDirector()->getScheduler()->scheduleUpdateForTarget(this, 0, false);
+	}
+}
+
+void oUnitBatch::remove( oUnit* unit )
+{
+	int index = unit->_batchIndex;
+	if (index < 0 || index >= (int)_units.size() || _units[index] != unit) return;
+	unit->_thinkDelta = _thinkDeltas[index];
+	unit->_batchIndex = -1;
+	if (_updating)
+	{
+		//Keep the order of units being iterated, compact after the update
+		_units[index] = nullptr;
+		_states[index] = Idle;
+		_reactionTimes[index] = -1.0f;
+		_dirty = true;
+	}
+	else
+	{
+		int last = (int)_units.size() - 1;
+		if (index != last) oUnitBatch::move(last, index);
+		oUnitBatch::resize(last);
+	}
+	if (--_unitCount == 0)
+	{
+		CCDirector::sharedDirector()->getScheduler()->unscheduleUpdateForTarget(this);
+	}
+}
+
+int oUnitBatch::getUnitCount() const
+{
+	return _unitCount;
+}
+
+void oUnitBatch::update( float dt )
+{
+	_updating = true;
+	int count = (int)_units.size();
+	/* timers run over the arrays, a unit is touched when one of them fires,
+	 requesting reflexes only queues the units */
+	for (int i = 0; i < count; i++)
+	{
+		oUnit* unit = _units[i];
+		if (!unit || !unit->_bodyB2->IsActive()) continue;
+		if (_states[i] == Idle)
+		{
+			if (unit->_currentAction) continue;
+			/* idle units think at intervals with random phases
+			 so that their evaluations spread across frames */
+			_thinkDeltas[i] += dt;
+			if (_thinkDeltas[i] >= oAI::thinkInterval)
+			{
+				_thinkDeltas[i] = 0.0f;
+				oAI::requestReflex(unit);
+			}
+		}
+		else if (_reactionTimes[i] >= 0.0f)
+		{
+			_reactionDeltas[i] += dt;
+			if (_reactionDeltas[i] >= _reactionTimes[i])
+			{
+				_reactionDeltas[i] = 0.0f;
+				oAI::requestReflex(unit);
+			}
+		}
+	}
+	/* movement intents of walking units, speeding up over the walk recovery */
+	for (int i = 0; i < count; i++)
+	{
+		if (_states[i] != Walking) continue;
+		oUnit* unit = _units[i];
+		float move = unit->move * unit->moveSpeed;
+		if (_walkElapsed[i] < _walkRecoveries[i])
+		{
+			_walkElapsed[i] += dt;
+			move *= MIN(_walkElapsed[i] / _walkRecoveries[i], 1.0f);
+		}
+		_moveIntents[i] = unit->isFaceRight() ? move : -move;
+	}
+	/* apply the intents and update other actions, scripts may run from here
+	 and units may join or leave, do not hold references to the arrays */
+	for (int i = 0; i < count; i++)
+	{
+		oUnit* unit = _units[i];
+		if (!unit || !unit->_bodyB2->IsActive() || !unit->_currentAction) continue;
+		if (_states[i] == Walking)
+		{
+			if (unit->isOnSurface())
+			{
+				unit->setVelocityX(_moveIntents[i]);
+			}
+			else unit->_currentAction->stop();
+		}
+		else unit->_currentAction->update(dt);
+		if (unit->_currentAction && !unit->_currentAction->isDoing())
+		{
+			unit->_currentAction = nullptr;
+			oAI::requestReflex(unit, true);
+		}
+	}
+	_updating = false;
+	if (_dirty)
+	{
+		oUnitBatch::compact();
+	}
+}
+
+void oUnitBatch::compact()
+{
+	int count = 0;
+	for (int i = 0; i < (int)_units.size(); i++)
+	{
+		if (_units[i])
+		{
+			if (i != count) oUnitBatch::move(i, count);
+			count++;
+		}
+	}
+	oUnitBatch::resize(count);
+	_dirty = false;
+}
+
+oUnitBatch* oUnitBatch::create()
+{
+	oUnitBatch* batch = new oUnitBatch();
+	batch->autorelease();
+	return batch;
+}
+
+bool oUnitBatch::isBatched( oUnit* unit )
+{
+	return unit->_batchIndex >= 0;
+}
+
+bool oUnitBatch::startAction( oUnit* unit, float reactionTime )
+{
+	int index = unit->_batchIndex;
+	if (index < 0) return false;
+	oUnitBatch* batch = unit->_unitDef->getBatch();
+	if (batch->_states[index] == Idle)
+	{
+		batch->_states[index] = Acting;
+	}
+	batch->_reactionTimes[index] = reactionTime;
+	batch->_reactionDeltas[index] = 0.0f;
+	return true;
+}
+
+bool oUnitBatch::startWalk( oUnit* unit, float recovery )
+{
+	int index = unit->_batchIndex;
+	if (index < 0) return false;
+	oUnitBatch* batch = unit->_unitDef->getBatch();
+	batch->_states[index] = Walking;
+	batch->_walkElapsed[index] = 0.0f;
+	batch->_walkRecoveries[index] = recovery;
+	batch->_moveIntents[index] = 0.0f;
+	return true;
+}
+
+bool oUnitBatch::stopAction( oUnit* unit )
+{
+	int index = unit->_batchIndex;
+	if (index < 0) return false;
+	oUnitBatch* batch = unit->_unitDef->getBatch();
+	batch->_states[index] = Idle;
+	batch->_reactionTimes[index] = -1.0f;
+	return true;
+}
+
+NS_DOROTHY_PLATFORM_END
\ No newline at end of file
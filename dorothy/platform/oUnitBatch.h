@@ -0,0 +1,62 @@
+/* Copyright (c) 2013 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#ifndef __DOROTHY_PLATFORM_OUNITBATCH_H__
+#define __DOROTHY_PLATFORM_OUNITBATCH_H__
+
+NS_DOROTHY_PLATFORM_BEGIN
+
+class oUnit;
+
+/** @brief Updates all units of one unit def from a single scheduler entry.
+ Enabled by oUnitDef::batchUpdate. Units join the batch when entering
+ the scene and leave when exiting. Their per frame state is kept in arrays
+ beside the unit list: think timers, the state and reaction timer of the
+ current action, and the walk ramp and movement intent of walking units.
+ An update runs the timers over the arrays first, then computes the
+ movement intents, then applies them and updates the other actions.
+ Reaction times are taken when an action starts.
+ Pausing the scheduler of a single batched unit does not stop its update.
+*/
+class oUnitBatch: public CCObject
+{
+public:
+	oUnitBatch();
+	virtual ~oUnitBatch();
+	void add(oUnit* unit);
+	void remove(oUnit* unit);
+	int getUnitCount() const;
+	virtual void update(float dt);
+	static oUnitBatch* create();
+	/** Actions report to the batch of their owner, returns false when the owner is not batched. */
+	static bool startAction(oUnit* unit, float reactionTime);
+	static bool startWalk(oUnit* unit, float recovery);
+	static bool stopAction(oUnit* unit);
+	static bool isBatched(oUnit* unit);
+private:
+	enum { Idle, Acting, Walking };
+	void push(oUnit* unit);
+	void move(int from, int to);
+	void resize(int count);
+	void compact();
+	vector<oUnit*> _units;
+	vector<float> _thinkDeltas;
+	vector<char> _states;
+	vector<float> _reactionTimes;//Negative when the current action does not react
+	vector<float> _reactionDeltas;
+	vector<float> _walkElapsed;
+	vector<float> _walkRecoveries;
+	vector<float> _moveIntents;//Velocity on x walking units want this frame
+	int _unitCount;
+	bool _updating;
+	bool _dirty;
+};
+
+NS_DOROTHY_PLATFORM_END
+
+#endif // __DOROTHY_PLATFORM_OUNITBATCH_H__
\ No newline at end of file
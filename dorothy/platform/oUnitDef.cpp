@@ -12,6 +12,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include "platform/oUnit.h"
 #include "platform/oBulletDef.h"
 #include "platform/oAI.h"
+#include "platform/oUnitBatch.h"
 
 #include "model/oModelDef.h"
 #include "model/oModelCache.h"
@@ -50,12 +51,22 @@ damageType(0),
 defenceType(0),
 hitEffect(),
 bulletType(),
+batchUpdate(false),
 _bodyDef(oBodyDef::create()),
 _density(1.0f),
 _friction(0.4f),
 _restitution(0.4f)
 { }
 
+oUnitBatch* oUnitDef::getBatch()
+{
+	if (_batch == nullptr)
+	{
+		_batch = oUnitBatch::create();
+	}
+	return _batch;
+}
+
 oUnitDef* oUnitDef::create()
 {
 	oUnitDef* unitDef = new oUnitDef();
@@ -18,6 +18,7 @@ NS_DOROTHY_END
 NS_DOROTHY_PLATFORM_BEGIN
 class oUnit;
 class oBulletDef;
+class oUnitBatch;
 
 class oUnitDef: public CCObject
 {
@@ -60,14 +61,18 @@ public:
 	string desc;
 	string sndAttack;
 	string sndDeath;
-	vector<string> actions;
+	vector<int> actions;//Action ids
 	vector<int> instincts;
+	/** Update units of this def from one shared oUnitBatch, applies to units created afterwards. */
+	bool batchUpdate;
+	oUnitBatch* getBatch();
 	static bool usePreciseHit;
 	static oUnitDef* create();
 protected:
 	oUnitDef();
 	void updateBodyDef();
 	oRef<oBodyDef> _bodyDef;
+	oRef<oUnitBatch> _batch;
 	oRef<oModelDef> _modelDef;
 	float _density;
 	float _friction;
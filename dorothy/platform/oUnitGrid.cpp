@@ -0,0 +1,164 @@
+/* Copyright (c) 2013 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include "const/oDefine.h"
+#include "platform/oPlatformDefine.h"
+#include "platform/oUnitGrid.h"
+#include "platform/oUnit.h"
+#include "platform/oData.h"
+#include <algorithm>
+
+NS_DOROTHY_PLATFORM_BEGIN
+
+oUnitGrid::oUnitGrid():
+cellSize(200.0f),
+_builtCellSize(0.0f),
+_dirty(true)
+{ }
+
+void oUnitGrid::add( oUnit* unit )
+{
+	if (unit->_gridIndex < 0)
+	{
+		unit->_gridIndex = (int)_units.size();
+		_units.push_back(unit);
+		_dirty = true;
+	}
+}
+
+void oUnitGrid::remove( oUnit* unit )
+{
+	int index = unit->_gridIndex;
+	if (index >= 0)
+	{
+		oUnit* last = _units.back();
+		_units[index] = last;
+		last->_gridIndex = index;
+		_units.pop_back();
+		unit->_gridIndex = -1;
+		/* entries may point to the removed unit, rebuild before next query */
+		_dirty = true;
+	}
+}
+
+int oUnitGrid::getUnitCount() const
+{
+	return (int)_units.size();
+}
+
+inline oUnitGrid::oCell oUnitGrid::getCell( float x, float y ) const
+{
+	oCell cell = {(int)floorf(x / _builtCellSize), (int)floorf(y / _builtCellSize)};
+	return cell;
+}
+
+inline int oUnitGrid::getBucket( const oCell& cell ) const
+{
+	unsigned int hash = ((unsigned int)cell.x * 73856093u) ^ ((unsigned int)cell.y * 19349663u);
+	return (int)(hash & (unsigned int)(_bucketStarts.size() - 2));
+}
+
+void oUnitGrid::markDirty()
+{
+	_dirty = true;
+}
+
+void oUnitGrid::update()
+{
+	if (!_dirty && _builtCellSize == cellSize)
+	{
+		return;
+	}
+	_dirty = false;
+	_builtCellSize = MAX(cellSize, 1.0f);
+	int bucketCount = 16;
+	while (bucketCount < (int)_units.size() * 2) bucketCount *= 2;
+	/* one extra slot keeps the end of the last bucket */
+	_bucketStarts.assign(bucketCount + 1, 0);
+	_entries.resize(_units.size());
+	vector<int> buckets(_units.size());
+	for (size_t i = 0; i < _units.size(); i++)
+	{
+		oUnit* unit = _units[i];
+		const CCPoint& pos = unit->getPosition();
+		oCell cell = oUnitGrid::getCell(pos.x, pos.y);
+		buckets[i] = oUnitGrid::getBucket(cell);
+		_bucketStarts[buckets[i] + 1]++;
+	}
+	for (int i = 0; i < bucketCount; i++)
+	{
+		_bucketStarts[i + 1] += _bucketStarts[i];
+	}
+	vector<int> offsets(_bucketStarts.begin(), _bucketStarts.end() - 1);
+	for (size_t i = 0; i < _units.size(); i++)
+	{
+		oUnit* unit = _units[i];
+		const CCPoint& pos = unit->getPosition();
+		oEntry& entry = _entries[offsets[buckets[i]]++];
+		entry.unit = unit;
+		entry.position = pos;
+		entry.cell = oUnitGrid::getCell(pos.x, pos.y);
+		entry.group = unit->getGroup();
+	}
+}
+
+void oUnitGrid::query( oUnit* self, float radius, oRelation relation, vector<oUnit*>& results ) const
+{
+	if (_entries.empty())
+	{
+		return;
+	}
+	bool anyRelation = relation == oRelation::Any || relation == oRelation::Unkown;
+	const CCPoint& center = self->getPosition();
+	int selfGroup = self->getGroup();
+	float radiusSQ = radius * radius;
+	oCell minCell = oUnitGrid::getCell(center.x - radius, center.y - radius);
+	oCell maxCell = oUnitGrid::getCell(center.x + radius, center.y + radius);
+	for (int y = minCell.y; y <= maxCell.y; y++)
+	{
+		for (int x = minCell.x; x <= maxCell.x; x++)
+		{
+			oCell cell = {x, y};
+			int bucket = oUnitGrid::getBucket(cell);
+			for (int i = _bucketStarts[bucket]; i < _bucketStarts[bucket + 1]; i++)
+			{
+				const oEntry& entry = _entries[i];
+				/* buckets are shared by cells with the same hash */
+				if (entry.cell.x != x || entry.cell.y != y || entry.unit == self)
+				{
+					continue;
+				}
+				if (ccpDistanceSQ(center, entry.position) > radiusSQ)
+				{
+					continue;
+				}
+				if (!anyRelation && !(oSharedData.getRelation(selfGroup, entry.group) & relation))
+				{
+					continue;
+				}
+				results.push_back(entry.unit);
+			}
+		}
+	}
+}
+
+void oUnitGrid::queryNearest( oUnit* self, int k, float radius, oRelation relation, vector<oUnit*>& results ) const
+{
+	size_t start = results.size();
+	oUnitGrid::query(self, radius, relation, results);
+	const CCPoint& center = self->getPosition();
+	auto closer = [&center](oUnit* a, oUnit* b)
+	{
+		return ccpDistanceSQ(center, a->getPosition()) < ccpDistanceSQ(center, b->getPosition());
+	};
+	size_t count = MIN((size_t)MAX(k, 0), results.size() - start);
+	std::partial_sort(results.begin() + start, results.begin() + start + count, results.end(), closer);
+	results.resize(start + count);
+}
+
+NS_DOROTHY_PLATFORM_END
@@ -0,0 +1,65 @@
+/* Copyright (c) 2013 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#ifndef __DOROTHY_PLATFORM_OUNITGRID_H__
+#define __DOROTHY_PLATFORM_OUNITGRID_H__
+
+NS_DOROTHY_PLATFORM_BEGIN
+
+class oUnit;
+
+/** @brief Uniform grid of units in a world for perception queries.
+ Units register when they enter the world. The grid is rebuilt
+ from unit positions at most once per world step before queries,
+ queries only read the grid and may run in parallel.
+*/
+class oUnitGrid
+{
+public:
+	oUnitGrid();
+	/** Cell size in points, should be close to the usual query radius. */
+	float cellSize;
+	void add(oUnit* unit);
+	void remove(oUnit* unit);
+	/** Rebuild the grid if units were added, removed or moved since last build. */
+	void update();
+	/** Called by the world after each step since units have moved. */
+	void markDirty();
+	/**
+	 Get units within the radius of the unit, self excluded.
+	 Use oRelation::Any or oRelation::Unkown to get units in any relation.
+	 */
+	void query(oUnit* self, float radius, oRelation relation, vector<oUnit*>& results) const;
+	/** Get the k nearest units within the radius, sorted by distance. */
+	void queryNearest(oUnit* self, int k, float radius, oRelation relation, vector<oUnit*>& results) const;
+	int getUnitCount() const;
+private:
+	struct oCell
+	{
+		int x;
+		int y;
+	};
+	struct oEntry
+	{
+		oUnit* unit;
+		oVec2 position;
+		oCell cell;
+		int group;
+	};
+	inline oCell getCell(float x, float y) const;
+	inline int getBucket(const oCell& cell) const;
+	vector<oUnit*> _units;
+	vector<oEntry> _entries;
+	vector<int> _bucketStarts;
+	float _builtCellSize;
+	bool _dirty;
+};
+
+NS_DOROTHY_PLATFORM_END
+
+#endif // __DOROTHY_PLATFORM_OUNITGRID_H__
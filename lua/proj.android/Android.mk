@@ -7,6 +7,8 @@ LOCAL_MODULE_FILENAME := liblua
 
 LOCAL_SRC_FILES := ../support/CCLuaEngine.cpp \
 		../support/DorothyXml.cpp \
+		../support/DorothyBytecode.cpp \
+		../support/DorothyAsync.cpp \
 		../support/DorothyModule.cpp \
 		../support/LuaBinding.cpp \
 		../support/LuaCode.cpp \
@@ -28,11 +28,15 @@
 #include "basics/CCScheduler.h"
 #include "LuaBinding.h"
 #include "DorothyXml.h"
+#include "DorothyBytecode.h"
+#include "DorothyAsync.h"
 #include "DorothyModule.h"
+#include "misc/oSizePool.h"
 
 NS_CC_BEGIN
 
 static int g_callFromLua = 0;
+static int g_tracebackRef = LUA_NOREF;
 
 static int cclua_print(lua_State* L)
 {
@@ -94,6 +98,11 @@ static int cclua_loadfile(lua_State* L, const string& file)
 				filename = std::move(newFileName);
 				isXml = true;
 			}
+			else if (oSharedContent.isFileExist((filename + ".luac").c_str()))
+			{
+				//Shipped with prebuilt bytecode only
+				filename += ".lua";
+			}
 			else
 			{
 				lua_pushnil(L);
@@ -108,42 +117,20 @@ static int cclua_loadfile(lua_State* L, const string& file)
 		isXml = extension == "xml";
 	}
 
-	unsigned long codeBufferSize = 0;
-	oOwnArray<char> buffer;
-	const char* codeBuffer = nullptr;
-	string codes;
-	if (isXml)
-	{
-		codes = oSharedXMLLoader.load(filename.c_str());
-		if (codes.empty())
-		{
-			luaL_error(L, "error parsing xml file: %s\n%s", filename.c_str(), oSharedXMLLoader.getLastError().c_str());
-		}
-		else
-		{
-			codeBuffer = codes.c_str();
-			codeBufferSize = codes.size();
-		}
-	}
-	else
-	{
-		buffer = oSharedContent.loadFile(filename.c_str(), codeBufferSize);
-		codeBuffer = buffer;
-	}
-	if (codeBuffer)
-	{
-		if (luaL_loadbuffer(L, codeBuffer, codeBufferSize, filename.c_str()) != 0)
-		{
-			luaL_error(L, "error loading module %s from file %s :\n\t%s",
-				lua_tostring(L, 1), filename.c_str(), lua_tostring(L, -1));
-		}
-	}
-	else
+	switch (oSharedBytecodeCache.load(L, filename, isXml))
 	{
+	case oBytecodeCache::XmlError:
+		luaL_error(L, "error parsing xml file: %s\n%s", filename.c_str(), oSharedXMLLoader.getLastError().c_str());
+		break;
+	case oBytecodeCache::LoadError:
+		luaL_error(L, "error loading module %s from file %s :\n\t%s",
+			lua_tostring(L, 1), filename.c_str(), lua_tostring(L, -1));
+		break;
+	case oBytecodeCache::NoFile:
 		luaL_error(L, "can not get file data of %s", filename.c_str());
+		break;
 	}
 	return 1;
-
 }
 
 static int cclua_loadfile(lua_State* L)
@@ -179,17 +166,17 @@ static int cclua_loader(lua_State* L)
 
 static int cclua_doXml(lua_State* L)
 {
-	string codes(luaL_checkstring(L, 1));
-	codes = oSharedXMLLoader.load(codes);
-	if (codes.empty())
+	string xml(luaL_checkstring(L, 1));
+	//Documents seen before skip translation and compiling
+	switch (oSharedBytecodeCache.loadXml(L, xml))
 	{
+	case oBytecodeCache::XmlError:
 		luaL_error(L, "error parsing local xml\n");
-	}
-	if (luaL_loadbuffer(L, codes.c_str(), codes.size(), "xml") != 0)
-	{
-		CCLOG("%s", codes.c_str());
+		break;
+	case oBytecodeCache::LoadError:
 		luaL_error(L, "error loading module %s from file %s :\n\t%s",
 			lua_tostring(L, 1), "xml", lua_tostring(L, -1));
+		break;
 	}
 	int top = lua_gettop(L) - 1;
 	CCLuaEngine::call(L, 0, LUA_MULTRET);
@@ -209,6 +196,219 @@ static int cclua_xmlToLua(lua_State* L)
 	return 1;
 }
 
+static int cclua_convertXml(lua_State* L)
+{
+	string sourceFolder(luaL_checkstring(L, 1));
+	string targetFolder(luaL_checkstring(L, 2));
+	bool bytecode = lua_toboolean(L, 3) != 0;
+	lua_pushinteger(L, oXmlLoader::convert(sourceFolder, targetFolder, bytecode));
+	return 1;
+}
+
+static int cclua_buildBytecode(lua_State* L)
+{
+	string filename(luaL_checkstring(L, 1));
+	string target(luaL_optstring(L, 2, oBytecodeCache::getPrebuiltName(filename).c_str()));
+	lua_pushboolean(L, oSharedBytecodeCache.build(L, filename, target) ? 1 : 0);
+	return 1;
+}
+
+static int cclua_clearBytecode(lua_State* L)
+{
+	oSharedBytecodeCache.clear();
+	return 0;
+}
+
+static int cclua_bytecodeStats(lua_State* L)
+{
+	oBytecodeCache& cache = oSharedBytecodeCache;
+	lua_createtable(L, 0, 7);
+	lua_pushinteger(L, cache.getMemoryHits());
+	lua_setfield(L, -2, "memoryHits");
+	lua_pushinteger(L, cache.getDiskHits());
+	lua_setfield(L, -2, "diskHits");
+	lua_pushinteger(L, cache.getPrebuiltHits());
+	lua_setfield(L, -2, "prebuiltHits");
+	lua_pushinteger(L, cache.getMisses());
+	lua_setfield(L, -2, "misses");
+	lua_pushnumber(L, (lua_Number)cache.getMemorySize());
+	lua_setfield(L, -2, "memorySize");
+	lua_pushnumber(L, cache.getColdTime());
+	lua_setfield(L, -2, "coldTime");
+	lua_pushnumber(L, cache.getWarmTime());
+	lua_setfield(L, -2, "warmTime");
+	if (lua_toboolean(L, 1))
+	{
+		cache.resetStats();
+	}
+	return 1;
+}
+
+/* the call path used before the cached traceback and reused boxes, kept for comparison */
+static int cclua_legacyExecute(lua_State* L, int handler, int numArgs)
+{
+	toluafix_get_function_by_refid(L, handler);// args... func
+	lua_insert(L, -(numArgs + 1));// func args...
+	int traceIndex = lua_gettop(L) - numArgs;
+	lua_pushcfunction(L, cclua_traceback);// func args... traceback
+	lua_insert(L, traceIndex);// traceback func args...
+	int error = lua_pcall(L, numArgs, 1, traceIndex);// traceback ret
+	lua_settop(L, traceIndex - 1);
+	return error ? 1 : 0;
+}
+
+static double cclua_time()
+{
+	struct cc_timeval time;
+	CCTime::gettimeofdayCocos2d(&time, nullptr);
+	return time.tv_sec + time.tv_usec / 1000000.0;
+}
+
+/* callBenchmark(function(item, deltaTime) end, count) returns calls per second
+ of the legacy path, the fast path and batched calls of 64 items,
+ a batched call gets the array of items in place of item */
+static int cclua_callBenchmark(lua_State* L)
+{
+	luaL_checktype(L, 1, LUA_TFUNCTION);
+	int count = luaL_optint(L, 2, 100000);
+	const int batchSize = 64;
+	static oVec2 item;
+	int handler = toluafix_ref_function(L, 1);
+	int typeId = CCLuaType<oVec2>();
+
+	double time = cclua_time();
+	for (int i = 0; i < count; i++)
+	{
+		tolua_pushusertype(L, &item, typeId);
+		lua_pushnumber(L, 0.016);
+		cclua_legacyExecute(L, handler, 2);
+	}
+	double legacyTime = cclua_time() - time;
+
+	time = cclua_time();
+	for (int i = 0; i < count; i++)
+	{
+		CCLuaEngine::pushUserType(L, &item, typeId);
+		lua_pushnumber(L, 0.016);
+		CCLuaEngine::execute(L, handler, 2);
+	}
+	double fastTime = cclua_time() - time;
+
+	lua_checkstack(L, batchSize + 1);
+	time = cclua_time();
+	for (int i = 0; i < count; i += batchSize)
+	{
+		int size = MIN(batchSize, count - i);
+		for (int n = 0; n < size; n++)
+		{
+			CCLuaEngine::pushUserType(L, &item, typeId);
+		}
+		CCLuaEngine::executeBatch(L, handler, size);
+	}
+	double batchTime = cclua_time() - time;
+
+	toluafix_remove_function_by_refid(L, handler);
+	lua_createtable(L, 0, 3);
+	lua_pushnumber(L, count / MAX(legacyTime, FLT_EPSILON));
+	lua_setfield(L, -2, "legacy");
+	lua_pushnumber(L, count / MAX(fastTime, FLT_EPSILON));
+	lua_setfield(L, -2, "fast");
+	lua_pushnumber(L, count / MAX(batchTime, FLT_EPSILON));
+	lua_setfield(L, -2, "batched");
+	return 1;
+}
+
+static int cclua_gcPacing(lua_State* L)
+{
+	CCLuaEngine::sharedEngine()->setGCPacing(lua_toboolean(L, 1) != 0);
+	return 0;
+}
+
+static int cclua_gcStats(lua_State* L)
+{
+	CCLuaEngine* engine = CCLuaEngine::sharedEngine();
+	lua_createtable(L, 0, 7);
+	lua_pushnumber(L, engine->getGCTime());
+	lua_setfield(L, -2, "time");
+	lua_pushinteger(L, engine->getGCSteps());
+	lua_setfield(L, -2, "steps");
+	lua_pushinteger(L, engine->getGCCycles());
+	lua_setfield(L, -2, "cycles");
+	lua_pushinteger(L, engine->getGCStepSize());
+	lua_setfield(L, -2, "stepSize");
+	lua_pushinteger(L, engine->getGCHeapSize());
+	lua_setfield(L, -2, "heapSize");
+	lua_createtable(L, CCLuaEngine::GCPauseBuckets, 0);
+	for (int i = 0; i < CCLuaEngine::GCPauseBuckets; i++)
+	{
+		lua_pushinteger(L, engine->getGCPauses(i));
+		lua_rawseti(L, -2, i + 1);
+	}
+	lua_setfield(L, -2, "pauses");
+	lua_createtable(L, CCLuaEngine::GCPauseBuckets - 1, 0);
+	for (int i = 0; i < CCLuaEngine::GCPauseBuckets - 1; i++)
+	{
+		lua_pushnumber(L, CCLuaEngine::GCPauseBounds[i]);
+		lua_rawseti(L, -2, i + 1);
+	}
+	lua_setfield(L, -2, "pauseBounds");
+	if (lua_toboolean(L, 1))
+	{
+		engine->resetGCStats();
+	}
+	return 1;
+}
+
+static int cclua_memoryStats(lua_State* L)
+{
+	oSizePool* pool = CCLuaEngine::sharedEngine()->getMemoryPool();
+	if (!pool)
+	{
+		lua_pushnil(L);
+		return 1;
+	}
+	lua_createtable(L, oSizePool::ClassCount + 1, 1);
+	for (int i = 0; i <= oSizePool::ClassCount; i++)
+	{
+		lua_createtable(L, 0, 4);
+		lua_pushinteger(L, (int)oSizePool::getClassSize(i));
+		lua_setfield(L, -2, "size");
+		lua_pushinteger(L, pool->getCount(i));
+		lua_setfield(L, -2, "count");
+		lua_pushinteger(L, pool->getAllocs(i));
+		lua_setfield(L, -2, "allocs");
+		lua_pushnumber(L, (lua_Number)pool->getBytes(i));
+		lua_setfield(L, -2, "bytes");
+		lua_rawseti(L, -2, i + 1);
+	}
+	lua_pushnumber(L, (lua_Number)pool->getCapacity());
+	lua_setfield(L, -2, "capacity");
+	if (lua_toboolean(L, 1))
+	{
+		pool->resetStats();
+	}
+	return 1;
+}
+
+static int cclua_sleepAsync(lua_State* L)
+{
+	oSharedAsyncScheduler.sleep(L, (float)luaL_checknumber(L, 1));
+	return 1;
+}
+
+static int cclua_loadAsync(lua_State* L)
+{
+	oSharedAsyncScheduler.loadFile(L, luaL_checkstring(L, 1));
+	return 1;
+}
+
+static int cclua_setThreadPoller(lua_State* L)
+{
+	luaL_checktype(L, 1, LUA_TFUNCTION);
+	oSharedAsyncScheduler.setPoller(toluafix_ref_function(L, 1));
+	return 0;
+}
+
 static int cclua_ubox(lua_State* L)
 {
 	lua_rawgeti(L, LUA_REGISTRYINDEX, TOLUA_UBOX);// ubox
@@ -238,14 +438,30 @@ static int cclua_loadlibs(lua_State* L)
 	return 1;
 }
 
-CCLuaEngine::CCLuaEngine()
+const float CCLuaEngine::GCPauseBounds[] = {0.0001f, 0.00025f, 0.0005f, 0.001f, 0.002f, 0.004f, 0.008f};
+
+CCLuaEngine::CCLuaEngine():
+_gcPacing(true),
+_gcCostPerKB(0.00001),
+_gcStepSize(0)
 {
-	L = luaL_newstate();
+	CCLuaEngine::resetGCStats();
+	_pool = new oSizePool();
+	L = CCLuaEngine::newState(_pool);
+	if (lua_getallocf(L, nullptr) != oSizePool::luaAlloc)
+	{
+		delete _pool;
+		_pool = nullptr;
+	}
 	cclua_loadlibs(L);
 	luaopen_lpeg(L);
 	toluafix_open(L);
 	tolua_LuaBinding_open(L);
 
+	// keep one traceback function instead of creating a closure for every call
+	lua_pushcfunction(L, cclua_traceback);
+	g_tracebackRef = luaL_ref(L, LUA_REGISTRYINDEX);
+
 	// Register our version of the global "print" function
 	const luaL_reg global_functions[] =
 	{
@@ -255,6 +471,17 @@ CCLuaEngine::CCLuaEngine()
 		{ "doXml", cclua_doXml },
 		{ "xmlToLua", cclua_xmlToLua },
 		{ "ubox", cclua_ubox },
+		{ "convertXml", cclua_convertXml },
+		{ "buildBytecode", cclua_buildBytecode },
+		{ "clearBytecode", cclua_clearBytecode },
+		{ "bytecodeStats", cclua_bytecodeStats },
+		{ "callBenchmark", cclua_callBenchmark },
+		{ "gcPacing", cclua_gcPacing },
+		{ "gcStats", cclua_gcStats },
+		{ "memoryStats", cclua_memoryStats },
+		{ "sleepAsync", cclua_sleepAsync },
+		{ "loadAsync", cclua_loadAsync },
+		{ "setThreadPoller", cclua_setThreadPoller },
 		{ NULL, NULL }
 	};
 	luaL_register(L, "_G", global_functions);
@@ -282,6 +509,9 @@ CCLuaEngine::CCLuaEngine()
 	tolua_beginmodule(L, "CCTextureCache");
 	tolua_function(L, "loadAsync", CCTextureCache_loadAsync);
 	tolua_endmodule(L);
+	tolua_beginmodule(L, "oModel");
+	tolua_function(L, "playAsync", oModel_playAsync);
+	tolua_endmodule(L);
 	tolua_endmodule(L);
 
 	tolua_LuaCode_open(L);
@@ -397,35 +627,35 @@ int CCLuaEngine::executeFunction(int nHandler, int paramCount)
 int CCLuaEngine::executeActionUpdate(int nHandler, void* param, int paramType, float deltaTime)
 {
 	if (!nHandler) return 0;
-	tolua_pushusertype(L, param, paramType);
+	CCLuaEngine::pushUserType(L, param, paramType);
 	lua_pushnumber(L, deltaTime);
 	return CCLuaEngine::execute(L, nHandler, 2);
 }
 
 int CCLuaEngine::executeNodeEvent(CCNode* pNode, int nAction)
 {
-	const char* name = nullptr;
+	int id = -1;
 	switch (nAction)
 	{
 	case CCNode::Enter:
-		name = oSlotList::Entering;
+		id = oSlotList::Entering;
 		break;
 	case CCNode::EnterTransitionDidFinish:
-		name = oSlotList::Entered;
+		id = oSlotList::Entered;
 		break;
 	case CCNode::Exit:
-		name = oSlotList::Exited;
+		id = oSlotList::Exited;
 		break;
 	case CCNode::ExitTransitionDidStart:
-		name = oSlotList::Exiting;
+		id = oSlotList::Exiting;
 		break;
 	case CCNode::Cleanup:
-		name = oSlotList::Cleanup;
+		id = oSlotList::Cleanup;
 		break;
 	default:
 		break;
 	}
-	oSlotList* slotList = CCNode_tryGetSlotList(pNode, name);
+	oSlotList* slotList = CCNode_tryGetSlotList(pNode, id);
 	if (slotList)
 	{
 		oRef<oSlotList> ref(slotList);
@@ -443,22 +673,22 @@ int CCLuaEngine::executeAppEvent(int nHandler, int eventType)
 
 int CCLuaEngine::executeMenuItemEvent(int eventType, CCMenuItem* menuItem)
 {
-	const char* name = nullptr;
+	int id = -1;
 	switch (eventType)
 	{
 	case CCMenuItem::TapBegan:
-		name = oSlotList::TapBegan;
+		id = oSlotList::TapBegan;
 		break;
 	case CCMenuItem::TapEnded:
-		name = oSlotList::TapEnded;
+		id = oSlotList::TapEnded;
 		break;
 	case CCMenuItem::Tapped:
-		name = oSlotList::Tapped;
+		id = oSlotList::Tapped;
 		break;
 	default:
 		break;
 	}
-	oSlotList* slotList = CCNode_tryGetSlotList(menuItem, name);
+	oSlotList* slotList = CCNode_tryGetSlotList(menuItem, id);
 	if (slotList)
 	{
 		oRef<oSlotList> ref(slotList);
@@ -477,25 +707,25 @@ int CCLuaEngine::executeSchedule(int nHandler, float dt)
 
 int CCLuaEngine::executeLayerTouchEvent(CCLayer* layer, int eventType, CCTouch* touch)
 {
-	const char* name = nullptr;
+	int id = -1;
 	switch (eventType)
 	{
 	case CCTouch::Began:
-		name = oSlotList::TouchBegan;
+		id = oSlotList::TouchBegan;
 		break;
 	case CCTouch::Moved:
-		name = oSlotList::TouchMoved;
+		id = oSlotList::TouchMoved;
 		break;
 	case CCTouch::Ended:
-		name = oSlotList::TouchEnded;
+		id = oSlotList::TouchEnded;
 		break;
 	case CCTouch::Cancelled:
-		name = oSlotList::TouchCancelled;
+		id = oSlotList::TouchCancelled;
 		break;
 	default:
 		break;
 	}
-	oSlotList* slotList(CCNode_tryGetSlotList(layer, name));
+	oSlotList* slotList(CCNode_tryGetSlotList(layer, id));
 	if (slotList)
 	{
 		oRef<oSlotList> ref(slotList);
@@ -507,25 +737,25 @@ int CCLuaEngine::executeLayerTouchEvent(CCLayer* layer, int eventType, CCTouch*
 
 int CCLuaEngine::executeLayerTouchesEvent(CCLayer* layer, int eventType, CCSet* touches)
 {
-	const char* name = nullptr;
+	int id = -1;
 	switch (eventType)
 	{
 	case CCTouch::Began:
-		name = oSlotList::TouchBegan;
+		id = oSlotList::TouchBegan;
 		break;
 	case CCTouch::Moved:
-		name = oSlotList::TouchMoved;
+		id = oSlotList::TouchMoved;
 		break;
 	case CCTouch::Ended:
-		name = oSlotList::TouchEnded;
+		id = oSlotList::TouchEnded;
 		break;
 	case CCTouch::Cancelled:
-		name = oSlotList::TouchCancelled;
+		id = oSlotList::TouchCancelled;
 		break;
 	default:
 		break;
 	}
-	oSlotList* slotList = CCNode_tryGetSlotList(layer, name);
+	oSlotList* slotList = CCNode_tryGetSlotList(layer, id);
 	if (slotList)
 	{
 		oRef<oSlotList> ref(slotList);
@@ -544,19 +774,19 @@ int CCLuaEngine::executeLayerTouchesEvent(CCLayer* layer, int eventType, CCSet*
 
 int CCLuaEngine::executeLayerKeypadEvent(CCLayer* layer, int eventType)
 {
-	const char* name = nullptr;
+	int id = -1;
 	switch (eventType)
 	{
 	case CCKeypad::Menu:
-		name = oSlotList::KeyMenu;
+		id = oSlotList::KeyMenu;
 		break;
 	case CCKeypad::Back:
-		name = oSlotList::KeyBack;
+		id = oSlotList::KeyBack;
 		break;
 	default:
 		break;
 	}
-	oSlotList* slotList(CCNode_tryGetSlotList(layer, name));
+	oSlotList* slotList(CCNode_tryGetSlotList(layer, id));
 	if (slotList)
 	{
 		oRef<oSlotList> ref(slotList);
@@ -627,7 +857,7 @@ int CCLuaEngine::call(lua_State* L, int paramCount, int returnCount)
 		return 0;
 	}
 
-	lua_pushcfunction(L, cclua_traceback);// func args... traceback
+	lua_rawgeti(L, LUA_REGISTRYINDEX, g_tracebackRef);// func args... traceback
 	lua_insert(L, traceIndex);// traceback func args...
 
 	++g_callFromLua;
@@ -695,6 +925,109 @@ int CCLuaEngine::invoke(lua_State* L, int nHandler, int numArgs, int numRets)
 	return CCLuaEngine::call(L, numArgs, numRets);
 }
 
+void CCLuaEngine::pushUserType(lua_State* L, void* value, int typeId)
+{
+	if (!value)
+	{
+		lua_pushnil(L);
+		return;
+	}
+	lua_rawgeti(L, LUA_REGISTRYINDEX, TOLUA_UBOX);// ubox
+	lua_pushlightuserdata(L, value);// ubox ptr
+	lua_rawget(L, -2);// ubox ud
+	if (lua_isuserdata(L, -1) && lua_getmetatable(L, -1))// ubox ud mt
+	{
+		lua_rawgeti(L, LUA_REGISTRYINDEX, typeId);// ubox ud mt typemt
+		bool sameType = lua_rawequal(L, -1, -2) != 0;
+		lua_pop(L, 2);// ubox ud
+		if (sameType)
+		{
+			lua_remove(L, -2);// ud
+			return;
+		}
+	}
+	lua_pop(L, 1);// ubox
+	tolua_pushusertype(L, value, typeId);// ubox newud
+	lua_pushlightuserdata(L, value);// ubox newud ptr
+	lua_pushvalue(L, -2);// ubox newud ptr newud
+	lua_rawset(L, -4);// ubox[ptr] = newud, ubox newud
+	lua_remove(L, -2);// newud
+}
+
+int CCLuaEngine::executeBatch(lua_State* L, int nHandler, int count)
+{
+	lua_createtable(L, count, 0);// items... array
+	lua_insert(L, -(count + 1));// array items...
+	for (int i = count; i > 0; i--)
+	{
+		lua_rawseti(L, -(i + 1), i);// array[i] = item, array items...
+	}
+	return CCLuaEngine::execute(L, nHandler, 1);
+}
+
+void CCLuaEngine::removeUserType(void* value)
+{
+	lua_rawgeti(L, LUA_REGISTRYINDEX, TOLUA_UBOX);// ubox
+	lua_pushlightuserdata(L, value);// ubox ptr
+	lua_rawget(L, -2);// ubox ud
+	if (!lua_isnil(L, -1))
+	{
+		lua_pushvalue(L, TOLUA_NOPEER);// ubox ud nopeer
+		lua_setfenv(L, -2);// ud<nopeer>, ubox ud
+		lua_pushlightuserdata(L, value);// ubox ud ptr
+		lua_pushnil(L);// ubox ud ptr nil
+		lua_rawset(L, -4);// ubox[ptr] = nil, ubox ud
+	}
+	lua_pop(L, 2);// empty
+}
+
+void CCLuaEngine::collectGarbage(float budget)
+{
+	if (!_gcPacing || budget <= 0.0f) return;
+	int stepSize = (int)(budget * 0.5f / _gcCostPerKB);
+	if (stepSize < 1) return;
+	_gcStepSize = MIN(stepSize, 4096);
+	double time = cclua_time();
+	if (lua_gc(L, LUA_GCSTEP, _gcStepSize))
+	{
+		_gcCycles++;
+	}
+	time = cclua_time() - time;
+	_gcCostPerKB = _gcCostPerKB * 0.8 + MAX(time / _gcStepSize, 1e-8) * 0.2;
+	_gcTime += time;
+	_gcSteps++;
+	int bucket = 0;
+	while (bucket < GCPauseBuckets - 1 && time >= GCPauseBounds[bucket]) bucket++;
+	_gcPauses[bucket]++;
+}
+
+int CCLuaEngine::getGCHeapSize() const
+{
+	return lua_gc(L, LUA_GCCOUNT, 0);
+}
+
+void CCLuaEngine::resetGCStats()
+{
+	_gcTime = 0.0;
+	_gcSteps = 0;
+	_gcCycles = 0;
+	for (int i = 0; i < GCPauseBuckets; i++)
+	{
+		_gcPauses[i] = 0;
+	}
+}
+
+lua_State* CCLuaEngine::newState(oSizePool* pool)
+{
+	lua_State* L = lua_newstate(oSizePool::luaAlloc, pool);
+	if (!L)
+	{
+		CCLOG("[WARNING] Lua state uses the default allocator since the custom one is not supported.");
+		L = luaL_newstate();
+	}
+	return L;
+}
+
 int CCLuaEngine::executeActionCreate(int nHandler)
 {
 	int handler = 0;
@@ -35,6 +35,8 @@ extern "C" {
 
 #include "cocos2d.h"
 
+namespace Dorothy { class oSizePool; }
+
 NS_CC_BEGIN
 
 // Lua support for cocos2d-x
@@ -44,6 +46,8 @@ public:
 	static CCLuaEngine* sharedEngine();
 
 	lua_State* getState() { return L; }
+	/** The size class pool of the state, null when the default allocator is in use. */
+	Dorothy::oSizePool* getMemoryPool() const { return _pool; }
 
 	/**
 	 @brief Add a path to find lua files in
@@ -60,6 +64,7 @@ public:
 	virtual void removeScriptHandler(int nHandler);
 
 	virtual void removePeer(CCObject* object);
+	virtual void removeUserType(void* value);
 	/**
 	 @brief Execute script code contained in the given string.
 	 @param codes holding the valid script code that should be executed.
@@ -99,6 +104,44 @@ public:
 	virtual bool executeAssert(bool cond, const char *msg = NULL);
 	virtual bool scriptHandlerEqual(int nHandlerA, int nHandlerB);
 
+	/**
+	 @brief Run incremental GC steps sized to fit half of the frame slack,
+	 the step size adapts to the measured cost of previous steps.
+	 */
+	virtual void collectGarbage(float budget);
+	void setGCPacing(bool var) { _gcPacing = var; }
+	bool isGCPacing() const { return _gcPacing; }
+	double getGCTime() const { return _gcTime; }
+	int getGCSteps() const { return _gcSteps; }
+	int getGCCycles() const { return _gcCycles; }
+	int getGCStepSize() const { return _gcStepSize; }
+	/** Lua heap size in KB */
+	int getGCHeapSize() const;
+	/** pauses counted by duration, buckets end at 0.1, 0.25, 0.5, 1, 2, 4, 8 ms and above */
+	enum { GCPauseBuckets = 8 };
+	static const float GCPauseBounds[GCPauseBuckets - 1];
+	int getGCPauses(int bucket) const { return _gcPauses[bucket]; }
+	void resetGCStats();
+
+	/**
+	 @brief Push a usertype reusing its box from the TOLUA_UBOX weak table,
+	 only for objects kept alive by C++ that are pushed every frame.
+	 Boxes are keyed by address, so an object deleted while its box is
+	 alive must call removeUserType, or the next object of the same type
+	 at that address gets the stale box and its peer table.
+	 */
+	static void pushUserType(lua_State* L, void* value, int typeId);
+	/**
+	 @brief Call a handler once with an array of the count values on the stack,
+	 instead of calling it count times. Make room for more than
+	 LUA_MINSTACK values with lua_checkstack before pushing them.
+	 */
+	static int executeBatch(lua_State* L, int nHandler, int count);
+	/**
+	 @brief Create a Lua state allocating from a size class pool, falls back
+	 to the default allocator where LuaJIT refuses custom ones (x64 builds).
+	 */
+	static lua_State* newState(Dorothy::oSizePool* pool);
 	static int call(lua_State* L, int paramCount, int returnCount);
 	static int execute(lua_State* L, int nHandler, int numArgs);
 	static int execute(lua_State* L, int numArgs);
@@ -106,6 +149,14 @@ public:
 private:
 	CCLuaEngine();
 	lua_State* L;
+	Dorothy::oSizePool* _pool;
+	bool _gcPacing;
+	double _gcCostPerKB;
+	double _gcTime;
+	int _gcSteps;
+	int _gcCycles;
+	int _gcStepSize;
+	int _gcPauses[GCPauseBuckets];
 };
 
 NS_CC_END
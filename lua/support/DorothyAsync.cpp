@@ -0,0 +1,291 @@
+#include "DorothyAsync.h"
+#include "CCLuaEngine.h"
+
+class oAsyncTicker: public CCObject
+{
+public:
+	virtual ~oAsyncTicker()
+	{
+		// unscheduled by the scheduler, as when purging the director
+		if (_current == this) _current = nullptr;
+	}
+	virtual void update(float dt)
+	{
+		oSharedAsyncScheduler.update(dt);
+	}
+	static void start()
+	{
+		if (!_current)
+		{
+			_current = new oAsyncTicker();
+			_current->autorelease();
+			// the scheduler keeps the ticker alive
+			CCDirector::sharedDirector()->getScheduler()->scheduleUpdateForTarget(_current, 0, false);
+		}
+	}
+	static void stop()
+	{
+		if (_current)
+		{
+			CCDirector::sharedDirector()->getScheduler()->unscheduleUpdateForTarget(_current);
+			_current = nullptr;
+		}
+	}
+private:
+	static oAsyncTicker* _current;
+};
+
+oAsyncTicker* oAsyncTicker::_current = nullptr;
+
+oAsyncScheduler::oAsyncScheduler():
+_poller(0),
+_pendingJobs(0),
+_time(0.0)
+{ }
+
+int oAsyncScheduler::getPendingJobs() const
+{
+	return _pendingJobs;
+}
+
+int oAsyncScheduler::createJob(lua_State* L)
+{
+	lua_createtable(L, 0, 3);// job
+	lua_pushboolean(L, 0);
+	lua_setfield(L, -2, "done");
+	lua_pushvalue(L, -1);// job job
+	_pendingJobs++;
+	if (!_timers.empty() || !_animationBindings.empty())
+	{
+		// the ticker may have been dropped by the scheduler
+		oAsyncScheduler::startTicking();
+	}
+	return luaL_ref(L, LUA_REGISTRYINDEX);// job
+}
+
+void oAsyncScheduler::release(lua_State* L, int job)
+{
+	luaL_unref(L, LUA_REGISTRYINDEX, job);
+	_pendingJobs--;
+}
+
+void oAsyncScheduler::finish(lua_State* L, int job, int count)
+{
+	lua_rawgeti(L, LUA_REGISTRYINDEX, job);// results... job
+	oAsyncScheduler::release(L, job);
+	lua_insert(L, -(count + 1));// job results...
+	for (int i = count; i > 0; i--)
+	{
+		lua_rawseti(L, -(i + 1), i);// job[i] = result, job results...
+	}
+	lua_pushinteger(L, count);
+	lua_setfield(L, -2, "n");
+	lua_pushboolean(L, 1);
+	lua_setfield(L, -2, "done");
+	lua_getfield(L, -1, "thread");// job thread
+	lua_State* thread = lua_tothread(L, -1);
+	if (thread && lua_status(thread) == LUA_YIELD)
+	{
+		lua_pushnil(L);
+		lua_setfield(L, -3, "thread");
+		oAsyncScheduler::resume(L, thread);
+	}
+	lua_pop(L, 2);
+}
+
+void oAsyncScheduler::resume(lua_State* L, lua_State* thread)
+{
+	lua_settop(thread, 0);// drop the values of the last yield
+	int status = lua_resume(thread, 0);
+	if (status == LUA_YIELD)
+	{
+		// a job yielded means the thread waits again, anything else asks for polling
+		bool detached = lua_gettop(thread) > 0 && lua_istable(thread, -1);
+		lua_settop(thread, 0);
+		if (!detached && _poller)
+		{
+			lua_pushthread(thread);
+			lua_xmove(thread, L, 1);// thread
+			CCLuaEngine::execute(L, _poller, 1);
+		}
+	}
+	else if (status != 0)
+	{
+		luaL_traceback(L, thread, lua_tostring(thread, -1), 0);// traceback
+		CCLog("[LUA ERROR] %s", lua_tostring(L, -1));
+		lua_pop(L, 1);
+		lua_settop(thread, 0);
+	}
+}
+
+void oAsyncScheduler::sleep(lua_State* L, float seconds)
+{
+	oTimer timer = {_time + MAX(seconds, 0.0f), oAsyncScheduler::createJob(L)};
+	_timers.push_back(timer);
+	std::push_heap(_timers.begin(), _timers.end());
+	oAsyncScheduler::startTicking();
+}
+
+void oAsyncScheduler::startTicking()
+{
+	oAsyncTicker::start();
+}
+
+void oAsyncScheduler::update(float dt)
+{
+	_time += dt;
+	lua_State* L = CCLuaEngine::sharedEngine()->getState();
+	while (!_timers.empty() && _timers.front().time <= _time)
+	{
+		std::pop_heap(_timers.begin(), _timers.end());
+		int job = _timers.back().job;
+		_timers.pop_back();
+		oAsyncScheduler::finish(L, job, 0);
+	}
+	oAsyncScheduler::checkAnimations(L);
+	if (_timers.empty() && _animationBindings.empty())
+	{
+		oAsyncTicker::stop();
+	}
+}
+
+void oAsyncScheduler::loadFile(lua_State* L, const string& filename)
+{
+	int job = oAsyncScheduler::createJob(L);
+	oSharedContent.loadFileAsyncUnsafe(filename.c_str(), [job](char* data, unsigned long size)
+	{
+		lua_State* L = CCLuaEngine::sharedEngine()->getState();
+		if (data) lua_pushlstring(L, data, size);
+		else lua_pushnil(L);
+		delete [] data;
+		oSharedAsyncScheduler.finish(L, job, 1);
+	});
+}
+
+void oAsyncScheduler::playAnimation(lua_State* L, oModel* model, const string& name)
+{
+	int job = oAsyncScheduler::createJob(L);
+	int index = model->getModelDef()->getAnimationIndexByName(name);
+	if (index == oAnimation::None)
+	{
+		oAsyncScheduler::finish(L, job, 0);
+		return;
+	}
+	auto it = std::find_if(_animationBindings.begin(), _animationBindings.end(), [&](const oAnimationBinding& binding)
+	{
+		return binding.model.get() == model && binding.index == index;
+	});
+	if (it == _animationBindings.end())
+	{
+		oAnimationEnd handler = {index};
+		model->handlers[index] += handler;
+		oAnimationBinding binding = {oWRef<oModel>(model), index};
+		_animationBindings.push_back(binding);
+	}
+	oAnimationWait wait = {oWRef<oModel>(model), index, job, false};
+	_animationWaits.push_back(wait);
+	model->play(index);
+	oAsyncScheduler::startTicking();
+}
+
+void oAsyncScheduler::oAnimationEnd::operator()(oModel* model) const
+{
+	oSharedAsyncScheduler.onAnimationEnd(model, index);
+}
+
+void oAsyncScheduler::onAnimationEnd(oModel* model, int index)
+{
+	lua_State* L = CCLuaEngine::sharedEngine()->getState();
+	vector<int> jobs;
+	for (auto it = _animationWaits.begin(); it != _animationWaits.end();)
+	{
+		if (it->model.get() == model && it->index == index)
+		{
+			jobs.push_back(it->job);
+			it = _animationWaits.erase(it);
+		}
+		else ++it;
+	}
+	// the handler stays attached while the delegate runs, the ticker detaches it
+	for (int job : jobs)
+	{
+		lua_pushboolean(L, 1);
+		oAsyncScheduler::finish(L, job, 1);
+	}
+}
+
+void oAsyncScheduler::checkAnimations(lua_State* L)
+{
+	vector<int> jobs;
+	for (auto it = _animationWaits.begin(); it != _animationWaits.end();)
+	{
+		oModel* model = it->model.get();
+		if (!model || (it->started && !model->isRunning()) || model->getCurrentAnimationIndex() != it->index)
+		{
+			// destroyed, exited, stopped or replaced by another animation
+			jobs.push_back(it->job);
+			it = _animationWaits.erase(it);
+		}
+		else
+		{
+			it->started = it->started || model->isRunning();
+			++it;
+		}
+	}
+	for (auto it = _animationBindings.begin(); it != _animationBindings.end();)
+	{
+		oModel* model = it->model.get();
+		bool waiting = model && std::any_of(_animationWaits.begin(), _animationWaits.end(), [&](const oAnimationWait& wait)
+		{
+			return wait.model.get() == model && wait.index == it->index;
+		});
+		if (waiting)
+		{
+			++it;
+			continue;
+		}
+		if (model)
+		{
+			oAnimationEnd handler = {it->index};
+			model->handlers[it->index] -= handler;
+		}
+		it = _animationBindings.erase(it);
+	}
+	for (int job : jobs)
+	{
+		lua_pushboolean(L, 0);
+		oAsyncScheduler::finish(L, job, 1);
+	}
+}
+
+void oAsyncScheduler::setPoller(int handler)
+{
+	if (_poller)
+	{
+		CCLuaEngine::sharedEngine()->removeScriptHandler(_poller);
+	}
+	_poller = handler;
+}
+
+int oModel_playAsync(lua_State* L)
+{
+	/* 1 self, 2 name */
+#ifndef TOLUA_RELEASE
+	tolua_Error tolua_err;
+	if (
+		!tolua_isusertype(L, 1, "oModel", 0, &tolua_err) ||
+		!tolua_isstring(L, 2, 0, &tolua_err) ||
+		!tolua_isnoobj(L, 3, &tolua_err)
+		)
+	{
+		tolua_error(L, "#ferror in function 'oModel_playAsync'.", &tolua_err);
+		return 0;
+	}
+#endif
+	oModel* self = (oModel*)tolua_tousertype(L, 1, 0);
+#ifndef TOLUA_RELEASE
+	if (!self) tolua_error(L, "invalid 'self' in function 'oModel_playAsync'", nullptr);
+#endif
+	oSharedAsyncScheduler.playAnimation(L, self, tolua_tostring(L, 2, 0));
+	return 1;
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+#ifndef __DOROTHY_ASYNC_H__
+#define __DOROTHY_ASYNC_H__
+
+#include "Dorothy.h"
+using namespace Dorothy;
+using namespace Dorothy::Platform;
+
+struct lua_State;
+
+/** @brief Jobs that Lua threads wait on without being polled every frame.
+ A job is a Lua table pushed by one of the functions below. wait(job) in a
+ thread stores the running coroutine in job.thread and yields the job,
+ which takes the thread out of oRoutine. When the job finishes its results
+ are stored in job[1..job.n], job.done is set and the thread is resumed.
+ A thread that yields false afterwards is handed to the poller so oRoutine
+ keeps the old per frame waits working.
+ Threads driven by an oAction are resumed by the action only, waiting on a
+ job there polls job.done each frame instead of detaching the thread.
+*/
+class oAsyncScheduler
+{
+public:
+	SHARED_FUNC(oAsyncScheduler);
+public:
+	/** Push a pending job table, returns the job id used to finish it. */
+	int createJob(lua_State* L);
+	/** Finish a job with the count values on top of the Lua stack. */
+	void finish(lua_State* L, int job, int count);
+	/** Push a job finishing after the seconds of scheduler time. */
+	void sleep(lua_State* L, float seconds);
+	/** Push a job loading a file on a worker thread, finishing with the data. */
+	void loadFile(lua_State* L, const string& filename);
+	/** Push a job playing a model animation. The job finishes with true when
+	 the animation ends, and with false when the animation is stopped or
+	 replaced, or when the model exits or is destroyed.
+	*/
+	void playAnimation(lua_State* L, oModel* model, const string& name);
+	/** Lua function called with threads that need polling again. */
+	void setPoller(int handler);
+	void update(float dt);
+	PROPERTY_READONLY(int, PendingJobs);
+protected:
+	oAsyncScheduler();
+private:
+	struct oTimer
+	{
+		double time;
+		int job;
+		bool operator<(const oTimer& other) const { return time > other.time; }
+	};
+	struct oAnimationWait
+	{
+		oWRef<oModel> model;
+		int index;
+		int job;
+		bool started;
+	};
+	struct oAnimationBinding
+	{
+		oWRef<oModel> model;
+		int index;
+	};
+	struct oAnimationEnd
+	{
+		int index;
+		void operator()(oModel* model) const;
+		bool operator==(const oAnimationEnd& other) const { return index == other.index; }
+	};
+	void onAnimationEnd(oModel* model, int index);
+	void checkAnimations(lua_State* L);
+	void startTicking();
+	void resume(lua_State* L, lua_State* thread);
+	void release(lua_State* L, int job);
+	int _poller;
+	int _pendingJobs;
+	double _time;
+	vector<oTimer> _timers;
+	vector<oAnimationWait> _animationWaits;
+	vector<oAnimationBinding> _animationBindings;
+};
+
+#define oSharedAsyncScheduler (*oAsyncScheduler::shared())
+
+int oModel_playAsync(lua_State* L);
+
+#endif //__DOROTHY_ASYNC_H__
\ No newline at end of file
@@ -0,0 +1,456 @@
+#include "DorothyBytecode.h"
+#include "CCLuaEngine.h"
+#include "DorothyXml.h"
+#include <fstream>
+
+/* Cached files start with this tag followed by the engine key and the source hash. */
+static const char g_bytecodeTag[] = { 'D', 'B', 'C', '2' };
+static const size_t g_headerSize = sizeof(g_bytecodeTag) + sizeof(unsigned long long) * 2;
+
+/* Bump it when the xml translator generates different codes. */
+static const char g_translatorVersion = 1;
+
+static double oBytecodeTime()
+{
+	cc_timeval now;
+	CCTime::gettimeofdayCocos2d(&now, nullptr);
+	return now.tv_sec + now.tv_usec / 1000000.0;
+}
+
+/* Files in the .game pack are not visible to the exist check,
+ reading a missing file from the pack fails quietly instead. */
+static bool oBytecodeExist(const string& filename)
+{
+	return oSharedContent.isUsingGameFile() || oSharedContent.isFileExist(filename.c_str());
+}
+
+static int oBytecodeWriter(lua_State* L, const void* p, size_t size, void* ud)
+{
+	((string*)ud)->append((const char*)p, size);
+	return 0;
+}
+
+oBytecodeCache::oBytecodeCache():
+_isEnabled(true),
+_isDiskEnabled(true),
+_memoryHits(0),
+_diskHits(0),
+_prebuiltHits(0),
+_misses(0),
+_memorySize(0),
+_memoryLimit(16 * 1024 * 1024),
+_coldTime(0),
+_warmTime(0),
+_engineKey(0)
+{ }
+
+oBytecodeCache::oHash oBytecodeCache::hash(const char* data, unsigned long size, bool isXml)
+{
+	//64 bit FNV-1a, xml and lua sources with the same text compile differently
+	oHash value = 14695981039346656037ULL;
+	value = (value ^ (isXml ? 'x' : 'l')) * 1099511628211ULL;
+	for (unsigned long i = 0; i < size; i++)
+	{
+		value = (value ^ (unsigned char)data[i]) * 1099511628211ULL;
+	}
+	return value;
+}
+
+oBytecodeCache::oHash oBytecodeCache::getEngineKey(lua_State* L)
+{
+	//The dump header holds the bytecode version and flags like FR2,
+	//the version string tells apart LuaJIT releases with the same format
+	string info;
+	if (luaL_loadstring(L, "") == 0)
+	{
+		lua_dump(L, oBytecodeWriter, &info);
+	}
+	lua_pop(L, 1);
+	info.resize(MIN(info.size(), (size_t)5));
+	//The engine does not open the jit library, which would turn the compiler on,
+	//so read jit.version from a throwaway state
+	lua_State* probe = luaL_newstate();
+	if (probe)
+	{
+		lua_pushcfunction(probe, luaopen_jit);
+		lua_pushstring(probe, LUA_JITLIBNAME);
+		if (lua_pcall(probe, 1, 0, 0) == 0)
+		{
+			lua_getfield(probe, LUA_REGISTRYINDEX, "_LOADED");
+			lua_getfield(probe, -1, LUA_JITLIBNAME);
+			if (lua_istable(probe, -1))
+			{
+				lua_getfield(probe, -1, "version");
+				if (lua_isstring(probe, -1)) info += lua_tostring(probe, -1);
+			}
+		}
+		lua_close(probe);
+	}
+	info += (char)sizeof(void*);
+	info += g_translatorVersion;
+	return oBytecodeCache::hash(info.c_str(), (unsigned long)info.size(), false);
+}
+
+string oBytecodeCache::getPrebuiltName(const string& filename)
+{
+	size_t pos = filename.rfind('.');
+	size_t slash = filename.find_last_of("/\\");
+	if (pos == string::npos || (slash != string::npos && pos < slash))
+	{
+		return filename + ".luac";
+	}
+	return filename.substr(0, pos) + ".luac";
+}
+
+string oBytecodeCache::getCachePath(const string& filename) const
+{
+	//One cache file for each source file, replaced when the source changes
+	char name[32];
+	sprintf(name, "%016llx.luac", oBytecodeCache::hash(filename.c_str(), (unsigned long)filename.size(), false));
+	return oSharedContent.getWritablePath() + "bytecode/" + name;
+}
+
+bool oBytecodeCache::loadBytecode(lua_State* L, const string& bytecode, const string& filename)
+{
+	if (luaL_loadbuffer(L, bytecode.c_str(), bytecode.size(), filename.c_str()) != 0)
+	{
+		lua_pop(L, 1);
+		return false;
+	}
+	return true;
+}
+
+static bool oBytecodeSplit(const char* data, size_t size, unsigned long long engine, unsigned long long key, bool anyKey, string& bytecode)
+{
+	if (size <= g_headerSize || memcmp(data, g_bytecodeTag, sizeof(g_bytecodeTag)) != 0)
+	{
+		return false;
+	}
+	unsigned long long fileEngine, fileKey;
+	memcpy(&fileEngine, data + sizeof(g_bytecodeTag), sizeof(fileEngine));
+	memcpy(&fileKey, data + sizeof(g_bytecodeTag) + sizeof(fileEngine), sizeof(fileKey));
+	if (fileEngine != engine || (!anyKey && fileKey != key))
+	{
+		return false;
+	}
+	bytecode.assign(data + g_headerSize, size - g_headerSize);
+	return true;
+}
+
+bool oBytecodeCache::readFile(const string& fullPath, oHash key, string& bytecode)
+{
+	std::ifstream stream(fullPath.c_str(), std::ios::in | std::ios::binary);
+	if (!stream)
+	{
+		return false;
+	}
+	string data((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+	return oBytecodeSplit(data.c_str(), data.size(), _engineKey, key, false, bytecode);
+}
+
+bool oBytecodeCache::readPrebuilt(const string& filename, oHash key, bool anyKey, string& bytecode)
+{
+	string prebuiltName = oBytecodeCache::getPrebuiltName(filename);
+	if (!oBytecodeExist(prebuiltName))
+	{
+		return false;
+	}
+	unsigned long size = 0;
+	oOwnArray<char> data = oSharedContent.loadFile(prebuiltName.c_str(), size);
+	return data && oBytecodeSplit(data, size, _engineKey, key, anyKey, bytecode);
+}
+
+bool oBytecodeCache::dump(lua_State* L, string& bytecode)
+{
+	bytecode.clear();
+	if (lua_dump(L, oBytecodeWriter, &bytecode) != 0)
+	{
+		bytecode.clear();
+		return false;
+	}
+	return true;
+}
+
+void oBytecodeCache::addChunk(const string& name, oHash key, string& bytecode)
+{
+	auto it = _chunks.find(name);
+	if (it != _chunks.end())
+	{
+		_memorySize -= it->second.bytecode.size();
+	}
+	if (_memorySize + bytecode.size() > _memoryLimit)
+	{
+		_chunks.clear();
+		_memorySize = 0;
+	}
+	_memorySize += bytecode.size();
+	oChunk& chunk = _chunks[name];
+	chunk.key = key;
+	chunk.bytecode = std::move(bytecode);
+}
+
+bool oBytecodeCache::writeFile(const string& fullPath, oHash engine, oHash key, const string& bytecode)
+{
+	std::ofstream stream(fullPath.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+	stream.write(g_bytecodeTag, sizeof(g_bytecodeTag));
+	stream.write((const char*)&engine, sizeof(engine));
+	stream.write((const char*)&key, sizeof(key));
+	stream.write(bytecode.c_str(), bytecode.size());
+	return !stream.fail();
+}
+
+int oBytecodeCache::compile(lua_State* L, const char* source, unsigned long size, bool isXml, const string& filename, string& bytecode)
+{
+	string codes;
+	if (isXml)
+	{
+		codes = oSharedXMLLoader.load(string(source, size));
+		if (codes.empty())
+		{
+			return oBytecodeCache::XmlError;
+		}
+		source = codes.c_str();
+		size = codes.size();
+	}
+	if (luaL_loadbuffer(L, source, size, filename.c_str()) != 0)
+	{
+		return oBytecodeCache::LoadError;
+	}
+	oBytecodeCache::dump(L, bytecode);
+	return oBytecodeCache::Loaded;
+}
+
+int oBytecodeCache::load(lua_State* L, const string& filename, bool isXml)
+{
+	double start = oBytecodeTime();
+	unsigned long size = 0;
+	oOwnArray<char> source;
+	if (oBytecodeExist(filename))
+	{
+		source = oSharedContent.loadFile(filename.c_str(), size);
+	}
+	string bytecode;
+	if (_engineKey == 0)
+	{
+		_engineKey = oBytecodeCache::getEngineKey(L);
+	}
+	if (!source)
+	{
+		//Shipped with prebuilt bytecode only
+		if (oBytecodeCache::readPrebuilt(filename, 0, true, bytecode)
+			&& oBytecodeCache::loadBytecode(L, bytecode, filename))
+		{
+			_prebuiltHits++;
+			_warmTime += oBytecodeTime() - start;
+			return oBytecodeCache::Loaded;
+		}
+		return oBytecodeCache::NoFile;
+	}
+	return oBytecodeCache::load(L, source, size, isXml, filename, true, start);
+}
+
+int oBytecodeCache::loadXml(lua_State* L, const string& xml)
+{
+	if (_engineKey == 0)
+	{
+		_engineKey = oBytecodeCache::getEngineKey(L);
+	}
+	return oBytecodeCache::load(L, xml.c_str(), (unsigned long)xml.size(), true, "xml", false, oBytecodeTime());
+}
+
+int oBytecodeCache::load(lua_State* L, const char* source, unsigned long size, bool isXml, const string& filename, bool isFile, double start)
+{
+	string bytecode;
+	if (!_isEnabled)
+	{
+		int result = oBytecodeCache::compile(L, source, size, isXml, filename, bytecode);
+		_misses++;
+		_coldTime += oBytecodeTime() - start;
+		return result;
+	}
+	oHash key = oBytecodeCache::hash(source, size, isXml);
+	string name = filename;
+	if (!isFile)
+	{
+		char text[32];
+		sprintf(text, "xml:%016llx", key);
+		name = text;
+	}
+	auto it = _chunks.find(name);
+	if (it != _chunks.end() && it->second.key == key
+		&& oBytecodeCache::loadBytecode(L, it->second.bytecode, filename))
+	{
+		_memoryHits++;
+		_warmTime += oBytecodeTime() - start;
+		return oBytecodeCache::Loaded;
+	}
+	bool useDisk = isFile && _isDiskEnabled;
+	string cachePath = useDisk ? oBytecodeCache::getCachePath(filename) : string();
+	bool found = false;
+	if (useDisk && oBytecodeCache::readFile(cachePath, key, bytecode)
+		&& oBytecodeCache::loadBytecode(L, bytecode, filename))
+	{
+		_diskHits++;
+		found = true;
+	}
+	else if (isFile && oBytecodeCache::readPrebuilt(filename, key, false, bytecode)
+		&& oBytecodeCache::loadBytecode(L, bytecode, filename))
+	{
+		_prebuiltHits++;
+		found = true;
+	}
+	if (found)
+	{
+		oBytecodeCache::addChunk(name, key, bytecode);
+		_warmTime += oBytecodeTime() - start;
+		return oBytecodeCache::Loaded;
+	}
+	int result = oBytecodeCache::compile(L, source, size, isXml, filename, bytecode);
+	if (result == oBytecodeCache::Loaded && !bytecode.empty())
+	{
+		if (useDisk)
+		{
+			string folder = oSharedContent.getWritablePath() + "bytecode";
+			if (!oSharedContent.isdir(folder.c_str()))
+			{
+				oSharedContent.mkdir(folder.c_str());
+			}
+			oBytecodeCache::writeFile(cachePath, _engineKey, key, bytecode);
+		}
+		oBytecodeCache::addChunk(name, key, bytecode);
+	}
+	_misses++;
+	_coldTime += oBytecodeTime() - start;
+	return result;
+}
+
+bool oBytecodeCache::build(lua_State* L, const string& filename, const string& target)
+{
+	bool isXml = oString::toLower(filename.substr(filename.rfind('.') + 1)) == "xml";
+	unsigned long size = 0;
+	oOwnArray<char> source = oSharedContent.loadFile(filename.c_str(), size);
+	if (!source)
+	{
+		return false;
+	}
+	string bytecode;
+	int result = oBytecodeCache::compile(L, source, size, isXml, filename, bytecode);
+	if (result == oBytecodeCache::LoadError)
+	{
+		CCLOG("%s", lua_tostring(L, -1));
+	}
+	else if (result == oBytecodeCache::XmlError)
+	{
+		CCLOG("%s", oSharedXMLLoader.getLastError().c_str());
+	}
+	if (result != oBytecodeCache::Loaded)
+	{
+		if (result == oBytecodeCache::LoadError) lua_pop(L, 1);
+		return false;
+	}
+	lua_pop(L, 1);
+	if (bytecode.empty())
+	{
+		return false;
+	}
+	if (_engineKey == 0)
+	{
+		_engineKey = oBytecodeCache::getEngineKey(L);
+	}
+	return oBytecodeCache::writeFile(target, _engineKey, oBytecodeCache::hash(source, size, isXml), bytecode);
+}
+
+void oBytecodeCache::clear()
+{
+	_chunks.clear();
+	_memorySize = 0;
+	string folder = oSharedContent.getWritablePath() + "bytecode";
+	if (oSharedContent.isdir(folder.c_str()))
+	{
+		auto files = oSharedContent.getDirEntries(folder.c_str(), false);
+		for (const string& file : files)
+		{
+			oSharedContent.removeFile((folder + '/' + file).c_str());
+		}
+	}
+}
+
+void oBytecodeCache::resetStats()
+{
+	_memoryHits = 0;
+	_diskHits = 0;
+	_prebuiltHits = 0;
+	_misses = 0;
+	_coldTime = 0;
+	_warmTime = 0;
+}
+
+void oBytecodeCache::setEnabled(bool var)
+{
+	_isEnabled = var;
+}
+
+bool oBytecodeCache::isEnabled() const
+{
+	return _isEnabled;
+}
+
+void oBytecodeCache::setDiskEnabled(bool var)
+{
+	_isDiskEnabled = var;
+}
+
+bool oBytecodeCache::isDiskEnabled() const
+{
+	return _isDiskEnabled;
+}
+
+void oBytecodeCache::setMemoryLimit(size_t var)
+{
+	_memoryLimit = var;
+	if (_memorySize > _memoryLimit)
+	{
+		_chunks.clear();
+		_memorySize = 0;
+	}
+}
+
+size_t oBytecodeCache::getMemoryLimit() const
+{
+	return _memoryLimit;
+}
+
+int oBytecodeCache::getMemoryHits() const
+{
+	return _memoryHits;
+}
+
+int oBytecodeCache::getDiskHits() const
+{
+	return _diskHits;
+}
+
+int oBytecodeCache::getPrebuiltHits() const
+{
+	return _prebuiltHits;
+}
+
+int oBytecodeCache::getMisses() const
+{
+	return _misses;
+}
+
+size_t oBytecodeCache::getMemorySize() const
+{
+	return _memorySize;
+}
+
+double oBytecodeCache::getColdTime() const
+{
+	return _coldTime;
+}
+
+double oBytecodeCache::getWarmTime() const
+{
+	return _warmTime;
+}
\ No newline at end of file
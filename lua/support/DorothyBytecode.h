@@ -0,0 +1,95 @@
+#ifndef __DOROTHY_BYTECODE_H__
+#define __DOROTHY_BYTECODE_H__
+
+#include "Dorothy.h"
+using namespace Dorothy;
+using namespace Dorothy::Platform;
+
+struct lua_State;
+
+/** @brief Cache of compiled Lua chunks keyed by file name and the hash of their source.
+ Chunks compiled from .lua and .xml files are kept in memory, saved under
+ the writable path, and can be prebuilt as .luac files shipped beside or
+ instead of the sources, for example inside the .game pack.
+ Changing a source changes its hash, and files carry the engine key of
+ the LuaJIT build and xml translator that made them, so stale bytecode
+ is never used. Each file keeps one entry in memory and on disk.
+*/
+class oBytecodeCache
+{
+public:
+	SHARED_FUNC(oBytecodeCache);
+public:
+	enum
+	{
+		Loaded,
+		NoFile,
+		XmlError,//Message from oSharedXMLLoader.getLastError()
+		LoadError//Message pushed onto the Lua stack
+	};
+	/** Push the chunk of a .lua or .xml file, compiled or taken from cache. */
+	int load(lua_State* L, const string& filename, bool isXml);
+	/** Push the chunk translated from an xml string, cached in memory only. */
+	int loadXml(lua_State* L, const string& xml);
+	/** Compile a source file into a prebuilt .luac file at the target path. */
+	bool build(lua_State* L, const string& filename, const string& target);
+	/** Name of the prebuilt bytecode file for a source file. */
+	static string getPrebuiltName(const string& filename);
+	/** Hash of a source, the key of its cached bytecode. */
+	typedef unsigned long long oHash;
+	static oHash hash(const char* data, unsigned long size, bool isXml);
+	/** Hash of the LuaJIT version, its build flags and the xml translator version,
+	 the version is read from a separate state that opens the jit library. */
+	static oHash getEngineKey(lua_State* L);
+	/** Dump the function on top of the stack, returns false if it can not be dumped. */
+	static bool dump(lua_State* L, string& bytecode);
+	/** Save bytecode with its engine key and source hash as a cache or prebuilt file. */
+	static bool writeFile(const string& fullPath, oHash engine, oHash key, const string& bytecode);
+	/** Drop all cached bytecode in memory and under the writable path. */
+	void clear();
+	void resetStats();
+	PROPERTY_BOOL_NAME(Enabled);
+	PROPERTY_BOOL_NAME(DiskEnabled);
+	/** Bytes of bytecode kept in memory, all are dropped when it is exceeded. */
+	PROPERTY_NAME(size_t, MemoryLimit);
+	PROPERTY_READONLY(int, MemoryHits);
+	PROPERTY_READONLY(int, DiskHits);
+	PROPERTY_READONLY(int, PrebuiltHits);
+	PROPERTY_READONLY(int, Misses);
+	PROPERTY_READONLY(size_t, MemorySize);
+	/** Seconds spent loading chunks that were not cached, including xml translation. */
+	PROPERTY_READONLY(double, ColdTime);
+	/** Seconds spent loading chunks from cache, including hashing the sources. */
+	PROPERTY_READONLY(double, WarmTime);
+protected:
+	oBytecodeCache();
+private:
+	string getCachePath(const string& filename) const;
+	bool loadBytecode(lua_State* L, const string& bytecode, const string& filename);
+	bool readFile(const string& fullPath, oHash key, string& bytecode);
+	bool readPrebuilt(const string& filename, oHash key, bool anyKey, string& bytecode);
+	void addChunk(const string& name, oHash key, string& bytecode);
+	int load(lua_State* L, const char* source, unsigned long size, bool isXml, const string& filename, bool isFile, double start);
+	int compile(lua_State* L, const char* source, unsigned long size, bool isXml, const string& filename, string& bytecode);
+	bool _isEnabled;
+	bool _isDiskEnabled;
+	int _memoryHits;
+	int _diskHits;
+	int _prebuiltHits;
+	int _misses;
+	size_t _memorySize;
+	size_t _memoryLimit;
+	double _coldTime;
+	double _warmTime;
+	oHash _engineKey;
+	struct oChunk
+	{
+		oHash key;
+		string bytecode;
+	};
+	unordered_map<string, oChunk> _chunks;//By file name, xml strings by their hash
+};
+
+#define oSharedBytecodeCache (*oBytecodeCache::shared())
+
+#endif //__DOROTHY_BYTECODE_H__
\ No newline at end of file
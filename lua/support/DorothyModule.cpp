@@ -1,6 +1,7 @@
 #include "DorothyModule.h"
 #include "CCLuaEngine.h"
 #include "tolua++.h"
+#include "misc/oIdTable.h"
 
 HANDLER_WRAP_START(oListenerHandlerWrapper)
 void call(oEvent* event) const
@@ -10,56 +11,151 @@ void call(oEvent* event) const
 	CCLuaEngine::sharedEngine()->executeFunction(getHandler(), 1, params, names);
 }
 HANDLER_WRAP_END
-static oListener* oListener_create(const string& name, int handler)
+
+/* Posted events gathered for batched listeners while a queue is flushed,
+ each handler gets them as one array when the queue is done. */
+static vector<std::pair<oHandlerWrapper, vector<oEvent*>>> g_eventBatches;
+static void oListener_sendBatches()
+{
+	if (g_eventBatches.empty()) return;
+	vector<std::pair<oHandlerWrapper, vector<oEvent*>>> batches;
+	batches.swap(g_eventBatches);
+	lua_State* L = CCLuaEngine::sharedEngine()->getState();
+	int typeId = CCLuaType<oEvent>();
+	for (const auto& batch : batches)
+	{
+		int count = (int)batch.second.size();
+		lua_checkstack(L, count + 1);
+		for (oEvent* event : batch.second)
+		{
+			tolua_pushusertype(L, event, typeId);
+		}
+		CCLuaEngine::executeBatch(L, batch.first.getHandler(), count);
+	}
+}
+HANDLER_WRAP_START(oBatchListenerHandlerWrapper)
+void call(oEvent* event) const
 {
+	if (oEvent::isBatched(event))
+	{
+		for (auto& batch : g_eventBatches)
+		{
+			if (batch.first == *this)
+			{
+				batch.second.push_back(event);
+				return;
+			}
+		}
+		g_eventBatches.push_back(std::make_pair(oHandlerWrapper(*this), vector<oEvent*>(1, event)));
+		return;
+	}
+	// events sent directly are not kept alive, handle them at once
+	lua_State* L = CCLuaEngine::sharedEngine()->getState();
+	tolua_pushusertype(L, event, CCLuaType<oEvent>());
+	CCLuaEngine::executeBatch(L, getHandler(), 1);
+}
+HANDLER_WRAP_END
+static oListener* oListener_create(const string& name, int handler, bool batched)
+{
+	if (batched)
+	{
+		static bool connected = false;
+		if (!connected)
+		{
+			connected = true;
+			oEvent::batchEnd += &oListener_sendBatches;
+		}
+		return oListener::create(name, std::make_pair(oBatchListenerHandlerWrapper(handler), &oBatchListenerHandlerWrapper::call));
+	}
 	return oListener::create(name, std::make_pair(oListenerHandlerWrapper(handler), &oListenerHandlerWrapper::call));
 }
 
-#define oSlotName(name) const char* oSlotList::name(#name);
-//Node
-oSlotName(Entering)
-oSlotName(Entered)
-oSlotName(Exiting)
-oSlotName(Exited)
-oSlotName(Cleanup)
-//Touch
-oSlotName(TouchBegan)
-oSlotName(TouchCancelled)
-oSlotName(TouchEnded)
-oSlotName(TouchMoved)
-//MenuItem
-oSlotName(TapBegan)
-oSlotName(TapEnded)
-oSlotName(Tapped)
-//Body
-oSlotName(ContactEnd)
-oSlotName(ContactStart)
-//Sensor
-oSlotName(BodyEnter)
-oSlotName(BodyLeave)
-//Keypad
-oSlotName(KeyBack)
-oSlotName(KeyMenu)
-//Acceleration
-oSlotName(Acceleration)
-oSlotName(InputAttach)
-oSlotName(InputDetach)
-oSlotName(InputInserting)
-oSlotName(InputInserted)
-oSlotName(InputDeleting)
-oSlotName(InputDeleted)
-oSlotName(AnimationEnd)
-oSlotName(ActionStart)
-oSlotName(ActionEnd)
-//Bullet
-oSlotName(HitTarget)
-//Camera
-oSlotName(CamMoved)
+#define oSlotName(name) #name,
+static oIdTable& oGetSlotNames()
+{
+	static oIdTable names;
+	if (names.getCount() == 0)
+	{
+		const char* builtins[] =
+		{
+			//Node
+			oSlotName(Entering)
+			oSlotName(Entered)
+			oSlotName(Exiting)
+			oSlotName(Exited)
+			oSlotName(Cleanup)
+			//Touch
+			oSlotName(TouchBegan)
+			oSlotName(TouchCancelled)
+			oSlotName(TouchEnded)
+			oSlotName(TouchMoved)
+			//Keypad
+			oSlotName(KeyBack)
+			oSlotName(KeyMenu)
+			//Acceleration
+			oSlotName(Acceleration)
+			//MenuItem
+			oSlotName(TapBegan)
+			oSlotName(TapEnded)
+			oSlotName(Tapped)
+			//Body
+			oSlotName(ContactEnd)
+			oSlotName(ContactStart)
+			//Sensor
+			oSlotName(BodyEnter)
+			oSlotName(BodyLeave)
+			//TextField
+			oSlotName(InputAttach)
+			oSlotName(InputDetach)
+			oSlotName(InputInserting)
+			oSlotName(InputInserted)
+			oSlotName(InputDeleting)
+			oSlotName(InputDeleted)
+			//Model
+			oSlotName(AnimationEnd)
+			//Unit
+			oSlotName(ActionStart)
+			oSlotName(ActionEnd)
+			//Bullet
+			oSlotName(HitTarget)
+			//Camera
+			oSlotName(CamMoved)
+		};
+		for (const char* name : builtins)
+		{
+			names.getId(string(name));
+		}
+		CCAssert(names.getCount() == oSlotList::BuiltinCount, "Builtin slot names do not match the slot ids.");
+	}
+	return names;
+}
+
+int oSlotList::getId(const char* name)
+{
+	return oGetSlotNames().getId(name);
+}
+
+int oSlotList::getId(const string& name)
+{
+	return oGetSlotNames().getId(name);
+}
+
+const string& oSlotList::getName(int id)
+{
+	return oGetSlotNames().getName(id);
+}
 
 class oSlotData : public CCObject
 {
 public:
 	static const int MAX_SLOT_ARRAY;
+	oSlotData()
+	{
+		for (int i = 0; i < INLINE_SLOT_COUNT; i++)
+		{
+			_inlineIds[i] = -1;
+		}
+	}
 	virtual ~oSlotData()
 	{
 		if (_gslotArray)
@@ -82,14 +178,14 @@ public:
 				}
 			}
 		}
-		if (_slotsArray)
+		for (int i = 0; i < INLINE_SLOT_COUNT; i++)
 		{
-			for (const auto& item : *_slotsArray)
+			if (_inlineSlots[i])
 			{
-				item.second->clear();
+				_inlineSlots[i]->clear();
 			}
 		}
-		else if (_slots)
+		if (_slots)
 		{
 			for (const auto& item : *_slots)
 			{
@@ -119,9 +215,9 @@ public:
 		}
 		return nullptr;
 	}
-	oListener* addGSlotItem(const char* name, int handler)
+	oListener* addGSlotItem(const char* name, int handler, bool batched)
 	{
-		oListener* listener = oListener_create(name, handler);
+		oListener* listener = oListener_create(name, handler, batched);
 		if (_gslot)
 		{
 			auto it = _gslot->find(name);
@@ -231,88 +327,62 @@ public:
 			}
 		}
 	}
-	oSlotList* tryGetSlotList(const char* name)
+	oSlotList* tryGetSlotList(int id)
 	{
-		if (_slots)
+		if (id < 0) return nullptr;
+		for (int i = 0; i < INLINE_SLOT_COUNT; i++)
 		{
-			auto it = _slots->find(name);
-			if (it != _slots->end()) return it->second;
-		}
-		else if (_slotsArray)
-		{
-			for (const auto& it : *_slotsArray)
+			if (_inlineIds[i] == id)
 			{
-				if (it.first == name)
-				{
-					return it.second;
-				}
+				return _inlineSlots[i];
 			}
 		}
+		if (_slots)
+		{
+			auto it = _slots->find(id);
+			if (it != _slots->end()) return it->second;
+		}
 		return nullptr;
 	}
-	oSlotList* getSlotList(const char* name)
+	oSlotList* getSlotList(int id)
 	{
-		if (_slots)
+		CCAssert(id >= 0, "Invalid slot id.");
+		oSlotList* slotList = oSlotData::tryGetSlotList(id);
+		if (slotList)
 		{
-			auto it = _slots->find(name);
-			if (it == _slots->end())
-			{
-				oSlotList* slotList = oSlotList::create();
-				(*_slots)[name] = slotList;
-				return slotList;
-			}
-			else return it->second;
+			return slotList;
 		}
-		else if (_slotsArray)
+		slotList = oSlotList::create();
+		for (int i = 0; i < INLINE_SLOT_COUNT; i++)
 		{
-			for (const auto& it : *_slotsArray)
-			{
-				if (it.first == name)
-				{
-					return it.second;
-				}
-			}
-			oSlotList* slotList = oSlotList::create();
-			if ((int)_slotsArray->size() < MAX_SLOT_ARRAY)
-			{
-				_slotsArray->push_back(std::make_pair(string(name), oRefMake(slotList)));
-			}
-			else
+			if (_inlineIds[i] < 0)
 			{
-				_slots = oOwnMake(new unordered_map<string,oRef<oSlotList>>());
-				for (const auto& item : *_slotsArray)
-				{
-					(*_slots)[item.first] = item.second;
-				}
-				_slotsArray = nullptr;
-				(*_slots)[name] = slotList;
+				_inlineIds[i] = id;
+				_inlineSlots[i] = slotList;
+				return slotList;
 			}
-			return slotList;
 		}
-		else
+		if (!_slots)
 		{
-			_slotsArray = oOwnMake(new vector<std::pair<string,oRef<oSlotList>>>());
-			oSlotList* slotList = oSlotList::create();
-			_slotsArray->push_back(std::make_pair(string(name),oRefMake(slotList)));
-			return slotList;
+			_slots = oOwnMake(new unordered_map<int,oRef<oSlotList>>());
 		}
+		(*_slots)[id] = slotList;
+		return slotList;
 	}
-	void removeSlotList(const char* name)
+	void removeSlotList(int id)
 	{
-		if (_slotsArray)
+		for (int i = 0; i < INLINE_SLOT_COUNT; i++)
 		{
-			for (auto it = _slotsArray->begin(); it != _slotsArray->end();++it)
+			if (_inlineIds[i] == id)
 			{
-				if (it->first == name)
-				{
-					_slotsArray->erase(it);
-					break;
-				}
+				_inlineIds[i] = -1;
+				_inlineSlots[i] = nullptr;
+				return;
 			}
 		}
-		else if (_slots)
+		if (_slots)
 		{
-			auto it = _slots->find(name);
+			auto it = _slots->find(id);
 			if (it != _slots->end()) _slots->erase(it);
 		}
 	}
@@ -320,8 +390,11 @@ public:
 private:
 	oOwn<unordered_map<string,oOwn<oRefVector<oListener>>>> _gslot;
 	oOwn<vector<std::pair<string,oOwn<oRefVector<oListener>>>>> _gslotArray;
-	oOwn<unordered_map<string,oRef<oSlotList>>> _slots;
-	oOwn<vector<std::pair<string,oRef<oSlotList>>>> _slotsArray;
+	//Slots of a node are few, keep them inline and search by id
+	enum { INLINE_SLOT_COUNT = 5 };
+	int _inlineIds[INLINE_SLOT_COUNT];
+	oRef<oSlotList> _inlineSlots[INLINE_SLOT_COUNT];
+	oOwn<unordered_map<int,oRef<oSlotList>>> _slots;
 	CC_LUA_TYPE(oSlotData)
 };
 const int oSlotData::MAX_SLOT_ARRAY = 5;
@@ -372,20 +445,22 @@ bool oSlotList::invoke(lua_State* L, int args)
 {
 	int top = lua_gettop(L);
 	int result = 1;
+	lua_rawgeti(L, LUA_REGISTRYINDEX, TOLUA_CALLBACK);// args... callbacks
+	int callbacks = top+1;
 	for (int i = 0;i < (int)_list.size();i++)
 	{
-		toluafix_get_function_by_refid(L, _list[i]);
+		lua_rawgeti(L, callbacks, _list[i]);// args... callbacks func
 		for (int index = top-args+1;index <= top;index++) lua_pushvalue(L, index);
 		if (CCLuaEngine::execute(L, args) == 0)
 		{
 			result = 0;
 		}
 	}
-	lua_pop(L, args);
+	lua_settop(L, top-args);
 	return result != 0;
 }
 
-oSlotList* CCNode_getSlotList(CCNode* self, const char* name)
+oSlotList* CCNode_getSlotList(CCNode* self, int id)
 {
 	CCAssert(self->getHelperObject() == 0 || CCLuaCast<oSlotData>(self->getHelperObject()), "Invalid slot object")
 	oSlotData* slotData = (oSlotData*)self->getHelperObject();
@@ -394,16 +469,17 @@ oSlotList* CCNode_getSlotList(CCNode* self, const char* name)
 		slotData = oSlotData::create();
 		self->setHelperObject(slotData);
 	}
-	return slotData->getSlotList(name);
+	return slotData->getSlotList(id);
 }
 
-oSlotList* CCNode_tryGetSlotList(CCNode* self, const char* name)
+oSlotList* CCNode_tryGetSlotList(CCNode* self, int id)
 {
 	CCAssert(self->getHelperObject() == 0 || CCLuaCast<oSlotData>(self->getHelperObject()), "Invalid slot object")
 	oSlotData* slotData = (oSlotData*)self->getHelperObject();
 	if (slotData)
 	{
-		return slotData->tryGetSlotList(name);
+		oSlotList* slotList = slotData->tryGetSlotList(id);
+		return slotList && !slotList->isEmpty() ? slotList : nullptr;
 	}
 	return nullptr;
 }
@@ -419,7 +495,8 @@ int CCNode_gslot(lua_State* L)
 		!(toluafix_isfunction(L, 3, &tolua_err) ||
 			lua_isnil(L, 3) ||
 			tolua_isnoobj(L, 3, &tolua_err)) ||
-		!tolua_isnoobj(L, 4, &tolua_err)
+		!tolua_isboolean(L, 4, 1, &tolua_err) ||
+		!tolua_isnoobj(L, 5, &tolua_err)
 		)
 		goto tolua_lerror;
 	else
@@ -443,7 +520,7 @@ int CCNode_gslot(lua_State* L)
 			if (lua_isfunction(L, 3)) // set
 			{
 				int handler = toluafix_ref_function(L, 3);
-				oListener* listener = slotData->addGSlotItem(name, handler);
+				oListener* listener = slotData->addGSlotItem(name, handler, lua_toboolean(L, 4) != 0);
 				tolua_pushccobject(L, listener);
 				return 1;
 			}
@@ -482,13 +559,25 @@ tolua_lerror :
 	return 0;
 }
 
+/* Slots are named by strings or by the ids from oSlotList.getId,
+ lookups by string are cached by the string address. */
+static int oSlotGetId(lua_State* L, int index)
+{
+	if (lua_type(L, index) == LUA_TNUMBER)
+	{
+		return (int)lua_tointeger(L, index);
+	}
+	return oSlotList::getId(lua_tostring(L, index));
+}
+
 int CCNode_slot(lua_State* L)
 {
 #ifndef TOLUA_RELEASE
 	tolua_Error tolua_err;
 	if (
 		!tolua_isusertype(L, 1, "CCNode", 0, &tolua_err) ||
-		!tolua_isstring(L, 2, 0, &tolua_err) ||
+		!(tolua_isstring(L, 2, 0, &tolua_err) ||
+			tolua_isnumber(L, 2, 0, &tolua_err)) ||
 		!(toluafix_isfunction(L, 3, &tolua_err) ||
 			lua_isnil(L, 3) ||
 			tolua_isnoobj(L, 3, &tolua_err)) ||
@@ -502,10 +591,10 @@ int CCNode_slot(lua_State* L)
 #ifndef TOLUA_RELEASE
 		if (!self) tolua_error(L, "invalid 'self' in function 'CCNode_slot'", NULL);
 #endif
-		const char* name = tolua_tostring(L, 2, 0);
+		int id = oSlotGetId(L, 2);
 		if (lua_isfunction(L, 3))
 		{
-			oSlotList* slotList = CCNode_getSlotList(self, name);
+			oSlotList* slotList = CCNode_getSlotList(self, id);
 			int handler = toluafix_ref_function(L, 3);
 			slotList->add(handler);
 			return 0;
@@ -516,11 +605,11 @@ int CCNode_slot(lua_State* L)
 			oSlotData* slotData = (oSlotData*)self->getHelperObject();
 			if (slotData)
 			{
-				slotData->removeSlotList(name);
+				slotData->removeSlotList(id);
 			}
 			return 0;
 		}
-		else tolua_pushccobject(L, (void*)CCNode_getSlotList(self, name));
+		else tolua_pushccobject(L, (void*)CCNode_getSlotList(self, id));
 	}
 	return 1;
 #ifndef TOLUA_RELEASE
@@ -536,7 +625,8 @@ int CCNode_emit(lua_State* L)
 	tolua_Error tolua_err;
 	if (
 		!tolua_isusertype(L, 1, "CCNode", 0, &tolua_err) ||
-		!tolua_isstring(L, 2, 0, &tolua_err)
+		!(tolua_isstring(L, 2, 0, &tolua_err) ||
+			tolua_isnumber(L, 2, 0, &tolua_err))
 		)
 		goto tolua_lerror;
 	else
@@ -546,8 +636,7 @@ int CCNode_emit(lua_State* L)
 #ifndef TOLUA_RELEASE
 		if (!self) tolua_error(L, "invalid 'self' in function 'CCNode_emit'", NULL);
 #endif
-		const char* name = tolua_tostring(L, 2, 0);
-		oSlotList* list = CCNode_tryGetSlotList(self, name);
+		oSlotList* list = CCNode_tryGetSlotList(self, oSlotGetId(L, 2));
 		if (list)
 		{
 			int top = lua_gettop(L);
@@ -676,9 +765,9 @@ oVec2 oModel_getKey(oModel* model, const char* key)
 	return model->getModelDef()->getKeyPoint(key);
 }
 
-inline void oHandleSensor(oSensor* sensor, oBody* other, const char* slotName)
+inline void oHandleSensor(oSensor* sensor, oBody* other, int slotId)
 {
-	oSlotList* slotList = CCNode_tryGetSlotList(sensor->getOwner(), slotName);
+	oSlotList* slotList = CCNode_tryGetSlotList(sensor->getOwner(), slotId);
 	if (slotList)
 	{
 		lua_State* L = CCLuaEngine::sharedEngine()->getState();
@@ -688,9 +777,9 @@ inline void oHandleSensor(oSensor* sensor, oBody* other, const char* slotName)
 	}
 }
 
-inline void oHandleContact(oBody* self, oBody* other, const oVec2& point, const oVec2& normal, const char* slotName)
+inline void oHandleContact(oBody* self, oBody* other, const oVec2& point, const oVec2& normal, int slotId)
 {
-	oSlotList* slotList = CCNode_tryGetSlotList(self, slotName);
+	oSlotList* slotList = CCNode_tryGetSlotList(self, slotId);
 	if (slotList)
 	{
 		lua_State* L = CCLuaEngine::sharedEngine()->getState();
@@ -728,9 +817,9 @@ oBody* oBody_create(oBodyDef* def, oWorld* world, oVec2 pos, float rot)
 	return body;
 }
 
-inline void oHandleAction(oAction* action, const char* slotName)
+inline void oHandleAction(oAction* action, int slotId)
 {
-	oSlotList* slotList = CCNode_tryGetSlotList(action->getOwner(), slotName);
+	oSlotList* slotList = CCNode_tryGetSlotList(action->getOwner(), slotId);
 	if (slotList)
 	{
 		lua_State* L = CCLuaEngine::sharedEngine()->getState();
@@ -1042,9 +1131,33 @@ void oUnitDef_setActions(oUnitDef* def, char* actions[], int count)
 	def->actions.clear();
 	for (int i = 0; i < count; i++)
 	{
-		def->actions.push_back(actions[i]);
+		def->actions.push_back(oAction::getId(actions[i]));
+	}
+}
+static oRef<oScriptHandler> g_lockstepHandler;
+static void oLockstep_onInput(int player, int key, float value)
+{
+	lua_State* L = CCLuaEngine::sharedEngine()->getState();
+	lua_pushnumber(L, player);
+	lua_pushnumber(L, key);
+	lua_pushnumber(L, value);
+	CCLuaEngine::execute(L, g_lockstepHandler->get(), 3);
+}
+void oLockstep_setInputHandler(int handler)
+{
+	oLockstep::inputReceived -= &oLockstep_onInput;
+	g_lockstepHandler = handler ? oScriptHandler::create(handler) : nullptr;
+	if (handler)
+	{
+		oLockstep::inputReceived += &oLockstep_onInput;
 	}
 }
+
+void oEvent_post(const char* name, bool coalesce)
+{
+	oEvent::post(oEventId(name), coalesce);
+}
+
 void oUnitDef_setInstincts(oUnitDef* def, int instincts[], int count)
 {
 	def->instincts.clear();
@@ -1054,6 +1167,22 @@ void oUnitDef_setInstincts(oUnitDef* def, int instincts[], int count)
 	}
 }
 
+void __oUnit_set(lua_State* L, oUnit* self, int id, float value)
+{
+	if (id < 0 || id >= oProperty::getIdCount())
+	{
+		luaL_error(L, "invalid property id %d in function 'oUnit.set'", id);
+	}
+	self->set(id, value);
+}
+float __oUnit_get(lua_State* L, oUnit* self, int id)
+{
+	if (id < 0 || id >= oProperty::getIdCount())
+	{
+		luaL_error(L, "invalid property id %d in function 'oUnit.get'", id);
+	}
+	return self->get(id);
+}
 void __oContent_loadFile(lua_State* L, oContent* self, const char* filename)
 {
 	unsigned long size = 0;
@@ -8,50 +8,57 @@ using namespace Dorothy::Platform;
 class oSlotList : public CCObject
 {
 public:
-	//builtin slot start
-	//Node
-	static const char* Entering;
-	static const char* Entered;
-	static const char* Exiting;
-	static const char* Exited;
-	static const char* Cleanup;
-	//Touch
-	static const char* TouchBegan;
-	static const char* TouchCancelled;
-	static const char* TouchEnded;
-	static const char* TouchMoved;
-	//Keypad
-	static const char* KeyBack;
-	static const char* KeyMenu;
-	//Acceleration
-	static const char* Acceleration;
-	//MenuItem
-	static const char* TapBegan;
-	static const char* TapEnded;
-	static const char* Tapped;
-	//Body
-	static const char* ContactEnd;
-	static const char* ContactStart;
-	//Sensor
-	static const char* BodyEnter;
-	static const char* BodyLeave;
-	//TextField
-	static const char* InputAttach;
-	static const char* InputDetach;
-	static const char* InputInserting;
-	static const char* InputInserted;
-	static const char* InputDeleting;
-	static const char* InputDeleted;
-	//Model
-	static const char* AnimationEnd;
-	//Unit
-	static const char* ActionStart;
-	static const char* ActionEnd;
-	//Bullet
-	static const char* HitTarget;
-	//Camera
-	static const char* CamMoved;
-	//builtin slot end
+	/* builtin slot ids, interned before any other slot name
+	 so they are usable as compile time constants */
+	enum
+	{
+		//Node
+		Entering,
+		Entered,
+		Exiting,
+		Exited,
+		Cleanup,
+		//Touch
+		TouchBegan,
+		TouchCancelled,
+		TouchEnded,
+		TouchMoved,
+		//Keypad
+		KeyBack,
+		KeyMenu,
+		//Acceleration
+		Acceleration,
+		//MenuItem
+		TapBegan,
+		TapEnded,
+		Tapped,
+		//Body
+		ContactEnd,
+		ContactStart,
+		//Sensor
+		BodyEnter,
+		BodyLeave,
+		//TextField
+		InputAttach,
+		InputDetach,
+		InputInserting,
+		InputInserted,
+		InputDeleting,
+		InputDeleted,
+		//Model
+		AnimationEnd,
+		//Unit
+		ActionStart,
+		ActionEnd,
+		//Bullet
+		HitTarget,
+		//Camera
+		CamMoved,
+		BuiltinCount
+	};
+	static int getId(const char* name);
+	static int getId(const string& name);
+	static const string& getName(int id);
 	oSlotList();
 	virtual ~oSlotList();
 	void set(int handler);
@@ -59,6 +66,7 @@ public:
 	bool remove(int handler);
 	void clear();
 	bool invoke(lua_State* L, int args = 0);
+	inline bool isEmpty() const { return _list.empty(); }
 	CREATE_FUNC(oSlotList)
 private:
 	vector<int> _list;
@@ -70,8 +78,9 @@ int CCNode_slot(lua_State* L);
 int CCNode_emit(lua_State* L);
 int CCNode_traverse(lua_State* L);
 int CCNode_eachChild(lua_State* L);
-oSlotList* CCNode_getSlotList(CCNode* self, const char* name);
-oSlotList* CCNode_tryGetSlotList(CCNode* self, const char* name);
+oSlotList* CCNode_getSlotList(CCNode* self, int id);
+/** Get the slot list only when it has handlers, so emitters can skip pushing arguments. */
+oSlotList* CCNode_tryGetSlotList(CCNode* self, int id);
 
 void CCDrawNode_drawPolygon(
 	CCDrawNode* self,
@@ -140,8 +149,14 @@ int oCache_poolCollect();
 int oCache_poolSize();
 
 void oUnitDef_setActions(oUnitDef* def, char* actions[], int count);
+void oLockstep_setInputHandler(int handler);
+void oEvent_post(const char* name, bool coalesce);
 void oUnitDef_setInstincts(oUnitDef* def, int instincts[], int count);
 
+void __oUnit_set(lua_State* L, oUnit* self, int id, float value);
+#define oUnit_set(self,id,value) __oUnit_set(tolua_S,self,id,value)
+float __oUnit_get(lua_State* L, oUnit* self, int id);
+#define oUnit_get(self,id) __oUnit_get(tolua_S,self,id)
 void __oContent_loadFile(lua_State* L, oContent* self, const char* filename);
 #define oContent_loadFile(self,filename) {__oContent_loadFile(tolua_S,self,filename);return 1;}
 void __oContent_getDirEntries(lua_State* L, oContent* self, const char* path, bool isFolder);
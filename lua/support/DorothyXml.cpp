@@ -1,4 +1,8 @@
 #include "DorothyXml.h"
+#include "DorothyBytecode.h"
+#include "CCLuaEngine.h"
+#include "misc/oSizePool.h"
+#include <fstream>
 
 static void oHandler(const char* begin, const char* end)
 {
@@ -23,11 +27,11 @@ static bool isVal(const char* value)
 }
 
 #if defined(COCOS2D_DEBUG) && COCOS2D_DEBUG > 0
-	#define toVal(s,def) (oVal(s,def,element,#s).c_str())
-	#define Val(s) (oVal(s,nullptr,element,#s).c_str())
+	#define toVal(s,def) (oVal(s,def,element,#s))
+	#define Val(s) (oVal(s,nullptr,element,#s))
 #else
-	#define toVal(s,def) (oVal(s,def).c_str())
-	#define Val(s) (oVal(s,nullptr).c_str())
+	#define toVal(s,def) (oVal(s,def))
+	#define Val(s) (oVal(s,nullptr))
 #endif
 
 static const char* _toBoolean(const char* str)
@@ -1504,12 +1508,16 @@ class oXmlDelegate : public CCSAXDelegator
 public:
 	oXmlDelegate(CCSAXParser* parser):
 	codes(nullptr),
-	parser(parser)
+	parser(parser),
+	arenaBlock(0),
+	arenaUsed(0)
 	{ }
 	virtual void startElement(void *ctx, const char *name, const char **atts);
 	virtual void endElement(void *ctx, const char *name);
 	virtual void textHandler(void *ctx, const char *s, int len);
-	string oVal(const char* value, const char* def = nullptr, const char* element = nullptr, const char* attr = nullptr);
+	/* Returns the attribute itself or a translated copy in the arena,
+	 valid until the next document begins. */
+	const char* oVal(const char* value, const char* def = nullptr, const char* element = nullptr, const char* attr = nullptr);
 public:
 	void clear()
 	{
@@ -1525,6 +1533,8 @@ public:
 		imported.clear();
 		firstItem.clear();
 		lastError.clear();
+		arenaBlock = 0;
+		arenaUsed = 0;
 	}
 	void begin()
 	{
@@ -1551,6 +1561,8 @@ public:
 		return lastError;
 	}
 private:
+	void missingAttribute(const char* element, const char* attr);
+	const char* addValue(const char* str, size_t length);
 	string getUsableName(const char* baseName)
 	{
 		char number[7];// max number can only have 6 digits
@@ -1594,157 +1606,148 @@ private:
 	unordered_map<string, string> attributes;
 	ostringstream stream;
 	ostringstream requires;
+	// Translated values
+	enum { ArenaBlockSize = 4096 };
+	string scratch;
+	vector<oOwnArray<char>> arena;
+	vector<size_t> arenaSizes;
+	size_t arenaBlock;
+	size_t arenaUsed;
 };
 
-string oXmlDelegate::oVal(const char* value, const char* def, const char* element, const char* attr)
+void oXmlDelegate::missingAttribute(const char* element, const char* attr)
+{
+	if (attr && element)
+	{
+		char num[10];
+		sprintf(num, "%d", parser->getLineNumber(element));
+		lastError += string("Missing attribute ") + (char)toupper(attr[0]) + string(attr).substr(1) + " for " + element + ", at line " + num + "\n";
+	}
+}
+
+const char* oXmlDelegate::oVal(const char* value, const char* def, const char* element, const char* attr)
 {
 	if (!value || !value[0])
 	{
-		if (def) return string(def);
-		else if (attr && element)
-		{
-			char num[10];
-			sprintf(num, "%d", parser->getLineNumber(element));
-			lastError += string("Missing attribute ") + (char)toupper(attr[0]) + string(attr).substr(1) + " for " + element + ", at line " + num + "\n";
-		}
-		return string();
+		if (def) return def;
+		oXmlDelegate::missingAttribute(element, attr);
+		return "";
 	}
-	if (value[0] == '{')
+	if (value[0] != '{')
 	{
-		string valStr(value);
-		if (valStr.back() != '}') return valStr;
-		size_t start = 1;
-		for (; valStr[start] == ' ' || valStr[start] == '\t'; ++start);
-		size_t end = valStr.size() - 2;
-		for (; valStr[end] == ' ' || valStr[end] == '\t'; --end);
-		if (end < start)
-		{
-			if (attr && element)
-			{
-				char num[10];
-				sprintf(num, "%d", parser->getLineNumber(element));
-				lastError += string("Missing attribute ") + (char)toupper(attr[0]) + string(attr).substr(1) + " for " + element + ", at line " + num + "\n";
-			}
-			return string();
-		}
-		valStr = valStr.substr(start, end - start + 1);
-		string newStr;
-		start = 0;
-		size_t i = 0;
-		while (i < valStr.size())
+		return value;
+	}
+	size_t length = strlen(value);
+	if (value[length - 1] != '}') return value;
+	const char* begin = value + 1;
+	for (; *begin == ' ' || *begin == '\t'; ++begin);
+	const char* end = value + length - 1;
+	for (; end > begin && (*(end - 1) == ' ' || *(end - 1) == '\t'); --end);
+	if (end <= begin)
+	{
+		oXmlDelegate::missingAttribute(element, attr);
+		return "";
+	}
+	scratch.clear();
+	const char* start = begin;
+	for (const char* c = begin; c < end; c++)
+	{
+		if ((*c != '$' && *c != '@') || c == end - 1) continue;
+		scratch.append(start, c - start);
+		char type = *c;
+		c++;
+		start = c + 1;
+		const char* parent = "CCDirector.winSize";
+		if (type == '$')
 		{
-			if ((valStr[i] == '$' || valStr[i] == '@') && i < valStr.size() - 1)
+			parent = nullptr;
+			if (!elementStack.empty())
 			{
-				if (valStr[i] == '$')
+				const oItem& top = elementStack.top();
+				if (!top.name.empty())
 				{
-					string parent;
-					if (!elementStack.empty())
-					{
-						oItem top = elementStack.top();
-						if (!top.name.empty())
-						{
-							parent = top.name;
-						}
-						else if (strcmp(top.type, "Stencil") == 0)
-						{
-							elementStack.pop();
-							if (!elementStack.empty())
-							{
-								const oItem& newTop = elementStack.top();
-								parent = newTop.name;
-							}
-							elementStack.push(top);
-						}
-					}
-					if (parent.empty() && element)
-					{
-						char num[10];
-						sprintf(num, "%d", parser->getLineNumber(element));
-						lastError += string("The $ expression can`t be used in tag at line ") + num + "\n";
-					}
-					newStr += valStr.substr(start, i - start);
-					i++;
-					start = i + 1;
-					switch (valStr[i])
-					{
-					case 'L':
-						newStr += "0";
-						break;
-					case 'W':
-					case 'R':
-						newStr += parent + ".width";
-						break;
-					case 'H':
-					case 'T':
-						newStr += parent + ".height";
-						break;
-					case 'B':
-						newStr += "0";
-						break;
-					case 'X':
-						newStr += parent + ".width*0.5";
-						break;
-					case 'Y':
-						newStr += parent + ".height*0.5";
-						break;
-					default:
-						if (element)
-						{
-							char num[10];
-							sprintf(num, "%d", parser->getLineNumber(element));
-							lastError += string("Invalid expression $") + valStr[i] + " at line " + num + "\n";
-						}
-						break;
-					}
+					parent = top.name.c_str();
 				}
-				else
+				else if (strcmp(top.type, "Stencil") == 0)
 				{
-					newStr += valStr.substr(start, i - start);
-					i++;
-					start = i + 1;
-					switch (valStr[i])
+					oItem stencil = elementStack.top();
+					elementStack.pop();
+					if (!elementStack.empty() && !elementStack.top().name.empty())
 					{
-					case 'L':
-						newStr += "0";
-						break;
-					case 'W':
-					case 'R':
-						newStr += "CCDirector.winSize.width";
-						break;
-					case 'H':
-					case 'T':
-						newStr += "CCDirector.winSize.height";
-						break;
-					case 'B':
-						newStr += "0";
-						break;
-					case 'X':
-						newStr += "CCDirector.winSize.width*0.5";
-						break;
-					case 'Y':
-						newStr += "CCDirector.winSize.height*0.5";
-						break;
-					default:
-						if (element)
-						{
-							char num[10];
-							sprintf(num, "%d", parser->getLineNumber(element));
-							lastError += string("Invalid expression @") + valStr[i] + " at line " + num + "\n";
-						}
-						break;
+						parent = elementStack.top().name.c_str();
 					}
+					elementStack.push(stencil);
 				}
 			}
-			i++;
+			if (!parent)
+			{
+				if (element)
+				{
+					char num[10];
+					sprintf(num, "%d", parser->getLineNumber(element));
+					lastError += string("The $ expression can`t be used in tag at line ") + num + "\n";
+				}
+				parent = "";
+			}
 		}
-		if (0 < start)
+		switch (*c)
 		{
-			if (start < valStr.size()) newStr += valStr.substr(start);
-			return newStr;
+		case 'L':
+		case 'B':
+			scratch += '0';
+			break;
+		case 'W':
+		case 'R':
+			scratch.append(parent).append(".width");
+			break;
+		case 'H':
+		case 'T':
+			scratch.append(parent).append(".height");
+			break;
+		case 'X':
+			scratch.append(parent).append(".width*0.5");
+			break;
+		case 'Y':
+			scratch.append(parent).append(".height*0.5");
+			break;
+		default:
+			if (element)
+			{
+				char num[10];
+				sprintf(num, "%d", parser->getLineNumber(element));
+				lastError += string("Invalid expression ") + type + *c + " at line " + num + "\n";
+			}
+			break;
 		}
-		else return valStr;
 	}
-	else return string(value);
+	if (start == begin)
+	{
+		return oXmlDelegate::addValue(begin, end - begin);
+	}
+	if (start < end) scratch.append(start, end - start);
+	return oXmlDelegate::addValue(scratch.c_str(), scratch.size());
+}
+
+const char* oXmlDelegate::addValue(const char* str, size_t length)
+{
+	size_t size = length + 1;
+	while (arenaBlock < arena.size() && arenaUsed + size > arenaSizes[arenaBlock])
+	{
+		arenaBlock++;
+		arenaUsed = 0;
+	}
+	if (arenaBlock == arena.size())
+	{
+		size_t blockSize = MAX(size, (size_t)oXmlDelegate::ArenaBlockSize);
+		arena.push_back(oOwnArray<char>(new char[blockSize]));
+		arenaSizes.push_back(blockSize);
+		arenaUsed = 0;
+	}
+	char* dest = arena[arenaBlock] + arenaUsed;
+	memcpy(dest, str, length);
+	dest[length] = '\0';
+	arenaUsed += size;
+	return dest;
 }
 
 void oXmlDelegate::startElement(void* ctx, const char* element, const char** atts)
@@ -2204,6 +2207,143 @@ string oXmlLoader::load(const string& xml)
 	return result ? _delegate->getResult() : string();
 }
 
+static void oXmlGather(const string& folder, const string& relative, vector<string>& files)
+{
+	string path = folder + relative;
+	auto entries = oSharedContent.getDirEntries(path.c_str(), false);
+	for (const string& file : entries)
+	{
+		size_t pos = file.rfind('.');
+		if (pos != string::npos && oString::toLower(file.substr(pos + 1)) == "xml")
+		{
+			files.push_back(relative + file);
+		}
+	}
+	auto folders = oSharedContent.getDirEntries(path.c_str(), true);
+	for (const string& sub : folders)
+	{
+		if (sub != "." && sub != "..")
+		{
+			oXmlGather(folder, relative + sub + '/', files);
+		}
+	}
+}
+
+static bool oXmlMakeDir(const string& path)
+{
+	//Create missing parent folders first, skipping the leading slash
+	for (size_t pos = path.find('/', 1); pos != string::npos; pos = path.find('/', pos + 1))
+	{
+		string folder = path.substr(0, pos);
+		if (!oSharedContent.isdir(folder.c_str()) && !oSharedContent.mkdir(folder.c_str()))
+		{
+			CCLOG("Create folder failed! %s", folder.c_str());
+			return false;
+		}
+	}
+	return true;
+}
+
+struct oXmlWorker
+{
+	oOwn<oXmlLoader> loader;
+	oOwn<oSizePool> pool;
+	lua_State* L;
+};
+
+int oXmlLoader::convert(const string& sourceFolder, const string& targetFolder, bool bytecode)
+{
+	string source = oSharedContent.getFullPath(sourceFolder.c_str());
+	if (!source.empty() && source.back() != '/') source += '/';
+	string target = oSharedContent.getFullPath(targetFolder.c_str());
+	if (!target.empty() && target.back() != '/') target += '/';
+	if (!oXmlMakeDir(target))
+	{
+		return 0;
+	}
+	vector<string> files;
+	oXmlGather(source, "", files);
+	//Create target folders up front, workers only read and write files
+	for (const string& file : files)
+	{
+		size_t pos = file.rfind('/');
+		if (pos != string::npos && !oXmlMakeDir(target + file.substr(0, pos + 1)))
+		{
+			return 0;
+		}
+	}
+	/* each file takes an idle loader and Lua state from the pool,
+	 the shared loader and the engine Lua state are never touched */
+	vector<oXmlWorker> workers;
+	workers.reserve(files.size());
+	vector<oXmlWorker*> idle;
+	pthread_mutex_t mutex;
+	pthread_mutex_init(&mutex, nullptr);
+	int converted = 0;
+	oParallel((int)files.size(), [&](int i)
+	{
+		pthread_mutex_lock(&mutex);
+		oXmlWorker* worker = nullptr;
+		if (idle.empty())
+		{
+			workers.push_back(oXmlWorker{oOwnNew<oXmlLoader>(), oOwnNew<oSizePool>(), nullptr});
+			worker = &workers.back();
+			if (bytecode) worker->L = CCLuaEngine::newState(worker->pool);
+		}
+		else
+		{
+			worker = idle.back();
+			idle.pop_back();
+		}
+		pthread_mutex_unlock(&mutex);
+		const string& file = files[i];
+		std::ifstream input((source + file).c_str(), std::ios::in | std::ios::binary);
+		string xml((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+		string codes = worker->loader->load(xml);
+		bool result = false;
+		if (codes.empty())
+		{
+			CCLOG("error parsing xml file: %s\n%s", file.c_str(), worker->loader->getLastError().c_str());
+		}
+		else if (bytecode)
+		{
+			lua_State* L = worker->L;
+			if (luaL_loadbuffer(L, codes.c_str(), codes.size(), file.c_str()) != 0)
+			{
+				CCLOG("%s", lua_tostring(L, -1));
+			}
+			else
+			{
+				string chunk;
+				if (oBytecodeCache::dump(L, chunk))
+				{
+					string name = oBytecodeCache::getPrebuiltName(target + file);
+					result = oBytecodeCache::writeFile(name, oBytecodeCache::getEngineKey(L), oBytecodeCache::hash(xml.c_str(), (unsigned long)xml.size(), true), chunk);
+					if (!result) CCLOG("write file failed! %s", name.c_str());
+				}
+			}
+			lua_settop(L, 0);
+		}
+		else
+		{
+			string name = target + file.substr(0, file.rfind('.')) + ".lua";
+			std::ofstream output(name.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+			result = !output.write(codes.c_str(), codes.size()).fail();
+			if (!result) CCLOG("write file failed! %s", name.c_str());
+		}
+		pthread_mutex_lock(&mutex);
+		if (result) converted++;
+		idle.push_back(worker);
+		pthread_mutex_unlock(&mutex);
+	});
+	for (oXmlWorker& worker : workers)
+	{
+		if (worker.L) lua_close(worker.L);
+	}
+	pthread_mutex_destroy(&mutex);
+	return converted;
+}
+
 string oXmlLoader::getLastError()
 {
 	const string& parserError = _parser.getLastError();
@@ -17,6 +17,12 @@ public:
 	string load(const char* filename);
 	string load(const string& xml);
 	string getLastError();
+	/** Translate every .xml file under the source folder to a .lua file,
+	 or to a prebuilt .luac file when bytecode is true, keeping the folder
+	 structure under the target folder, which is created when missing.
+	 Files are translated in parallel, failures are logged,
+	 returns the number of files converted. */
+	static int convert(const string& sourceFolder, const string& targetFolder, bool bytecode);
 private:
 	oOwn<oXmlDelegate> _delegate;
 	CCSAXParser _parser;
@@ -14,6 +14,11 @@ builtin.oData = builtin.oData()
 local tolua = builtin.tolua
 local yield = coroutine.yield
 local wrap = coroutine.wrap
+local create = coroutine.create
+local resume = coroutine.resume
+local running = coroutine.running
+local status = coroutine.status
+local unpack = unpack
 local CCDirector = builtin.CCDirector
 local table_insert = table.insert
 local table_remove = table.remove
@@ -31,7 +36,34 @@ builtin.ccmsg = function(title, ...)
 end
 builtin.CCMessageBox = nil
 
+-- threads resumed by their owner every frame, such as oAction routines
+local polledThreads = setmetatable({}, {__mode = "k"})
+
+-- cond is a condition function polled every frame,
+-- or a job from sleepAsync, loadAsync or oModel.playAsync
+-- that resumes the thread when done and returns its results
 local function wait(cond)
+	if type(cond) == "table" then
+		if not cond.done then
+			local thread = running()
+			if not thread then
+				error("Waiting for a job must be in a thread.")
+			end
+			if polledThreads[thread] then
+				-- only the owner may resume the thread, poll the job instead
+				repeat yield(false) until cond.done
+				return unpack(cond, 1, cond.n)
+			end
+			cond.thread = thread
+			yield(cond)
+			if not cond.done then
+				-- resumed early by a poller such as an oAction, keep polling
+				cond.thread = nil
+				repeat yield(false) until cond.done
+			end
+		end
+		return unpack(cond, 1, cond.n)
+	end
 	repeat
 		yield(false)
 	until not cond(CCDirector.deltaTime)
@@ -125,6 +157,19 @@ end
 
 oRoutine:start()
 
+-- threads resumed by finished jobs come back here when they need polling
+_G.setThreadPoller(function(thread)
+	oRoutine(function()
+		local success, result = resume(thread)
+		if not success then
+			CCLuaLog(result)
+			return true
+		end
+		return status(thread) == "dead" or type(result) == "table"
+	end)
+end)
+_G.setThreadPoller = nil
+
 builtin.oRoutine = oRoutine
 builtin.wait = wait
 builtin.once = once
@@ -204,8 +249,11 @@ end
 
 local CCNode_gslot = builtin.CCNode.gslot
 builtin.CCNode.gslot = function(self,name,...)
-	local handler = select(1,...)
-	if handler then
+	local handler,batched = ...
+	if handler and batched then
+		-- posted events of a flush come in one array, emit args are not passed
+		return CCNode_gslot(self,name,handler,true)
+	elseif handler then
 		return CCNode_gslot(self,name, function(event)
 			handler(oEvent_args[argsCount],event)
 		end)
@@ -224,7 +272,18 @@ oAction.add = function(self,id,priority,reaction,recovery,access,routine,stop)
 		recovery,
 		access,
 		function()
-			return once(routine)
+			local thread = create(function()
+				routine()
+				return true
+			end)
+			polledThreads[thread] = true
+			return function()
+				local success, result = resume(thread)
+				if not success then
+					error(result, 0)
+				end
+				return result
+			end
 		end,
 		stop)
 end
@@ -8,6 +8,13 @@ class oAI
 	static oUnit* getNearestUnit(oRelation relation);
 	static float getNearestUnitDistance(oRelation relation);
 
+	static bool useUnitGrid;
+	static float thinkInterval;
+	static float frameBudget;
+	static tolua_readonly tolua_property__common int evaluationCount;
+	static tolua_readonly tolua_property__common int deferredCount;
+	static tolua_readonly tolua_property__common float evaluationCostP99;
+
 	static void add(const char* name, oAILeaf* leaf);
 	static void clear();
 };
@@ -13,3 +13,9 @@ oAILeaf* oParSel(oAILeaf* nodes[tolua_len]);
 oAILeaf* oParSeq(oAILeaf* nodes[tolua_len]);
 oAILeaf* oCon(tolua_function handler);
 oAILeaf* oAct(const char* actionId);
+oAILeaf* oConDetect(oRelation relation);
+oAILeaf* oConNearer(oRelation relation, float distance);
+oAILeaf* oConFarther(oRelation relation, float distance);
+oAILeaf* oConLess(const char* propName, float value);
+oAILeaf* oConGreater(const char* propName, float value);
+oAILeaf* oConOnSurface();
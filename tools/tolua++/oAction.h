@@ -3,6 +3,7 @@ class oAction
 	float reaction;
 	float recovery;
 	tolua_readonly tolua_property__common string name;
+	tolua_readonly tolua_property__common int id;
 	tolua_readonly tolua_property__common int priority;
 	tolua_readonly tolua_property__bool bool doing;
 	tolua_readonly tolua_property__common oUnit* owner;
@@ -15,4 +16,5 @@ class oAction
 		tolua_function create,
 		tolua_function stop);
 	static void clear();
+	static int getId @ getActionId(const char* name);
 };
@@ -4,6 +4,12 @@ class oBulletDef: public CCObject
 	string endEffect;
 	float lifeTime;
 	float damageRadius;
+	int poolCapacity;
+	tolua_readonly tolua_property__common int poolIdleCount;
+	tolua_readonly tolua_property__common int poolActiveCount;
+	tolua_readonly tolua_property__common int poolPeakCount;
+	tolua_readonly tolua_property__common int poolCreatedCount;
+	tolua_readonly tolua_property__common int poolReusedCount;
 	tolua_property__bool bool highSpeedFix;
 	tolua_property__common float gravityScale;
 	tolua_property__common oFace* face;
@@ -11,6 +17,7 @@ class oBulletDef: public CCObject
 	tolua_readonly tolua_property__common oVec2 velocity;
 
 	void setAsCircle(float radius);
+	void clearPool();
 	void setVelocity(float angle, float speed);
 	static tolua_readonly const int SensorTag;
 	static oBulletDef* create();
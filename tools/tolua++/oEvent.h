@@ -3,4 +3,6 @@ class oEvent
 	tolua_readonly tolua_property__common string name;
 };
 
-void oEvent::send @ emit(string& name);
\ No newline at end of file
+void oEvent::send @ emit(const char* name);
+void oEvent_post @ post(const char* name, bool coalesce = false);
+void oEvent::flush @ flush();
\ No newline at end of file
@@ -0,0 +1,19 @@
+class oEventQueue
+{
+	enum
+	{
+		DropNewest,
+		Wait
+	};
+
+	static int drain();
+	static void resetStats();
+
+	static tolua_property__common int capacity;
+	static tolua_property__common int overflowPolicy;
+	static tolua_property__common int maxDrain;
+	static tolua_readonly tolua_property__common unsigned int posted;
+	static tolua_readonly tolua_property__common unsigned int dropped;
+	static tolua_readonly tolua_property__common unsigned int delivered;
+	static tolua_readonly tolua_property__common int pending;
+};
\ No newline at end of file
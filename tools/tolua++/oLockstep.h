@@ -0,0 +1,24 @@
+class oLockstep
+{
+	enum
+	{
+		Idle,
+		Recording,
+		Replaying
+	};
+
+	static void start(unsigned int seed, float tickInterval = 1.0f/60.0f);
+	static void replay();
+	static unsigned int runHeadless();
+	static void stop();
+	static void post(int player, int key, float value);
+	static bool save(const char* filename);
+	static bool load(const char* filename);
+	static tolua_outside void oLockstep_setInputHandler @ setInputHandler(tolua_function handler);
+
+	static tolua_readonly tolua_property__common int state;
+	static tolua_readonly tolua_property__common unsigned int tick;
+	static tolua_readonly tolua_property__common unsigned int tickCount;
+	static tolua_readonly tolua_property__common unsigned int seed;
+	static tolua_readonly tolua_property__common float tickInterval;
+};
\ No newline at end of file
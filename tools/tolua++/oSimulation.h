@@ -0,0 +1,13 @@
+class oSimulation: public CCObject
+{
+	tolua_readonly tolua_property__common oPlatformWorld* world;
+	tolua_readonly tolua_property__common unsigned int seed;
+	tolua_readonly tolua_property__common float time;
+	float tickInterval;
+	float timeLimit;
+	void track(oUnit* unit);
+	float run();
+	string getCSV(bool withHeader = false);
+	bool saveCSV(const char* filename);
+	static oSimulation* create(unsigned int seed = 0);
+};
\ No newline at end of file
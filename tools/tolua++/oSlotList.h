@@ -4,4 +4,5 @@ class oSlotList : public CCObject
 	void add(tolua_function handler);
 	bool remove(tolua_function handler);
 	void clear();
+	static int getId(const char* name);
 };
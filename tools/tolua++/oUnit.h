@@ -43,6 +43,9 @@ class oUnit: public oBody
 	bool start(const char* name);
 	void stop();
 	bool isDoing(const char* name);
+	oAction* getAction(int id);
+	bool start(int id);
+	bool isDoing(int id);
 	
 	void attachInstinct(int id);
 	void removeInstinct(int id);
@@ -50,8 +53,11 @@ class oUnit: public oBody
 	
 	void set(const char* name, float value);
 	float get(const char* name);
+	tolua_outside void oUnit_set @ set(int id, float value);
+	tolua_outside float oUnit_get @ get(int id);
 	void remove(const char* name);
 	void clear();
 	
+	static int getPropertyId @ propertyId(const char* name);
 	static tolua_outside oUnit* oUnit_create @ create(oUnitDef* unitDef, oWorld* world, oVec2 pos = oVec2::zero, float rot = 0);
 };
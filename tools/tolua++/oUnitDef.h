@@ -28,6 +28,7 @@ class oUnitDef: public CCObject
 	float attackBase;
 	float attackDelay;
 	float attackEffectDelay;
+	bool batchUpdate;
 	CCSize attackRange;
 	oVec2 attackPower;
 	oAttackType attackType;